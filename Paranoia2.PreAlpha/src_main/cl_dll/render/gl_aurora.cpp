@@ -50,6 +50,109 @@ void UTIL_RemoveAurora( cl_entity_t *ent )
 	}
 }
 
+CParticleArena :: CParticleArena( void )
+{
+	m_pChunks = NULL;
+	m_iNumFreeBlocks = 0;
+}
+
+CParticleArena :: ~CParticleArena( void )
+{
+	Clear();
+}
+
+CParticle *CParticleArena :: Alloc( int iParticles, int &iCapacity )
+{
+	CParticle *pBlock = NULL;
+	int i, best = -1;
+
+	// reuse the smallest released block that fits
+	for( i = 0; i < m_iNumFreeBlocks; i++ )
+	{
+		if( m_FreeBlocks[i].maxparticles < iParticles )
+			continue;
+
+		if( best == -1 || m_FreeBlocks[i].maxparticles < m_FreeBlocks[best].maxparticles )
+			best = i;
+	}
+
+	if( best != -1 )
+	{
+		pBlock = m_FreeBlocks[best].particles;
+		iCapacity = m_FreeBlocks[best].maxparticles;
+		m_FreeBlocks[best] = m_FreeBlocks[--m_iNumFreeBlocks];
+		memset( pBlock, 0, sizeof( CParticle ) * iParticles );
+		return pBlock;
+	}
+
+	// carve from the current chunk
+	aurorachunk_t *chunk = m_pChunks;
+
+	if( !chunk || ( chunk->numparticles + iParticles ) > chunk->maxparticles )
+	{
+		int maxparticles = Q_max( iParticles, AURORA_ARENA_CHUNK );
+
+		// not a Mem_Alloc: the manager is static and may outlive the engine
+
+		chunk = (aurorachunk_t *)malloc( sizeof( aurorachunk_t ) + sizeof( CParticle ) * maxparticles );
+
+		if( !chunk )
+		{
+			iCapacity = 0;
+			return NULL;
+		}
+
+		chunk->particles = (CParticle *)(chunk + 1);
+		chunk->maxparticles = maxparticles;
+		chunk->numparticles = 0;
+		chunk->next = m_pChunks;
+		m_pChunks = chunk;
+	}
+
+	pBlock = chunk->particles + chunk->numparticles;
+	chunk->numparticles += iParticles;
+	iCapacity = iParticles;
+	memset( pBlock, 0, sizeof( CParticle ) * iParticles );
+
+	return pBlock;
+}
+
+void CParticleArena :: Free( CParticle *pBlock, int iParticles )
+{
+	if( !pBlock || iParticles <= 0 )
+		return;
+
+	// give back the tail of the current chunk
+	if( m_pChunks && pBlock + iParticles == m_pChunks->particles + m_pChunks->numparticles )
+	{
+		m_pChunks->numparticles -= iParticles;
+		return;
+	}
+
+	// otherwise keep it for the next system. If the list is full the block
+	// is simply lost until the arena is cleared on a level change
+	if( m_iNumFreeBlocks < MAX_AURORA_FREEBLOCKS )
+	{
+		m_FreeBlocks[m_iNumFreeBlocks].particles = pBlock;
+		m_FreeBlocks[m_iNumFreeBlocks].maxparticles = iParticles;
+		m_iNumFreeBlocks++;
+	}
+}
+
+void CParticleArena :: Clear( void )
+{
+	aurorachunk_t *chunk, *next;
+
+	for( chunk = m_pChunks; chunk; chunk = next )
+	{
+		next = chunk->next;
+		free( chunk );
+	}
+
+	m_pChunks = NULL;
+	m_iNumFreeBlocks = 0;
+}
+
 CParticleSystemManager :: CParticleSystemManager( void )
 {
 	m_pFirstSystem = NULL;
@@ -94,6 +197,7 @@ void CParticleSystemManager :: MarkSystemForDeletion( CParticleSystem *pSys )
 // blended particles don't use the z-buffer, so we need to sort them before drawing.
 // for efficiency, only the systems are sorted - individual particles just get drawn in order of creation.
 // (this should actually make things look better - no ugly popping when one particle passes through another.)
+// the list keeps its order between frames so the insertion sort usually makes a single pass
 void CParticleSystemManager :: SortSystems( void )
 {
 	CParticleSystem *pSystem, *pLast;
@@ -176,15 +280,13 @@ void CParticleSystemManager :: UpdateSystems( void )
 
 	pSystem = m_pFirstSystem;
 
+	// update all the systems first so they can be sorted back to front
 	while( pSystem )
 	{
 		state = pSystem->UpdateSystem( frametime );
 
 		if( state != AURORA_REMOVE )
 		{
-			if( state == AURORA_DRAW )
-				pSystem->DrawSystem();
-
 			pLast = pSystem;
 			pSystem = pSystem->m_pNextSystem;
 		}
@@ -207,6 +309,12 @@ void CParticleSystemManager :: UpdateSystems( void )
 		}
 	}
 
+	SortSystems();
+
+	// DrawSystem skips the systems outside of PVS by itself
+	for( pSystem = m_pFirstSystem; pSystem; pSystem = pSystem->m_pNextSystem )
+		pSystem->DrawSystem();
+
 	pglTexEnvi( GL_TEXTURE_ENV, GL_RGB_SCALE_ARB, 1 );
 	pglTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
 	gEngfuncs.pTriAPI->RenderMode( kRenderNormal );
@@ -225,6 +333,7 @@ void CParticleSystemManager :: ClearSystems( void )
 	}
 
 	m_pFirstSystem = NULL;
+	m_Arena.Clear();
 }
 
 CParticleType :: CParticleType( CParticleType *pNext )
@@ -360,6 +469,8 @@ bool CParticleSystem :: c_bCosTableInit = false;
 CParticleSystem :: CParticleSystem( cl_entity_t *ent, const char *szFilename, int attachment, float lifetime )
 {
 	int iParticles = 100; // default
+	m_pAllParticles = NULL;
+	m_iMaxParticles = 0;
 	m_iKillCondition = CONTENTS_NONE;
 	m_iEntAttachment = attachment;
 	m_pActiveParticle = NULL;
@@ -459,12 +570,17 @@ CParticleSystem :: CParticleSystem( cl_entity_t *ent, const char *szFilename, in
 
 void CParticleSystem :: AllocateParticles( int iParticles )
 {
-	m_pAllParticles = new CParticle[iParticles];
-	memset( m_pAllParticles, 0, sizeof( CParticle ) * iParticles );
+	m_pAllParticles = g_pParticleSystems.m_Arena.Alloc( iParticles, m_iMaxParticles );
 	m_pFreeParticle = m_pAllParticles;
 	m_pActiveParticle = NULL;
 	m_pMainParticle = NULL;
 
+	if( !m_pAllParticles )
+	{
+		ALERT( at_error, "couldn't allocate %i aurora particles\n", iParticles );
+		return;
+	}
+
 	// initialise the linked list
 	CParticle *pLast = m_pAllParticles;
 	CParticle *pParticle = pLast + 1;
@@ -481,7 +597,7 @@ void CParticleSystem :: AllocateParticles( int iParticles )
 
 CParticleSystem :: ~CParticleSystem( void )
 {
-	delete[] m_pAllParticles;
+	g_pParticleSystems.m_Arena.Free( m_pAllParticles, m_iMaxParticles );
 
 	CParticleType *pType = m_pFirstType;
 	CParticleType *pNext;
@@ -165,6 +165,39 @@ public:
 	char		m_szName[32];
 };
 
+// particles of all the systems are carved from the shared arena chunks
+#define AURORA_ARENA_CHUNK		8192	// particles per arena chunk
+#define MAX_AURORA_FREEBLOCKS		256	// released blocks kept for reuse
+
+typedef struct aurorachunk_s
+{
+	struct aurorachunk_s	*next;
+	int			maxparticles;
+	int			numparticles;	// already carved out
+	CParticle			*particles;	// follows the header
+} aurorachunk_t;
+
+typedef struct
+{
+	CParticle		*particles;
+	int		maxparticles;
+} aurorablock_t;
+
+class CParticleArena
+{
+public:
+	CParticleArena( void );
+	~CParticleArena( void );
+
+	CParticle *Alloc( int iParticles, int &iCapacity );	// capacity may be larger if a block is reused
+	void Free( CParticle *pBlock, int iParticles );
+	void Clear( void );				// release all the chunks
+private:
+	aurorachunk_t	*m_pChunks;
+	aurorablock_t	m_FreeBlocks[MAX_AURORA_FREEBLOCKS];
+	int		m_iNumFreeBlocks;
+};
+
 typedef enum
 {
 	AURORA_REMOVE = 0,
@@ -223,6 +256,7 @@ private:
 
 	// the block of allocated particles
 	CParticle		*m_pAllParticles;
+	int		m_iMaxParticles;
 
 	// First particles in the linked list for the active particles and the dead particles
 	CParticle		*m_pFreeParticle;
@@ -243,6 +277,8 @@ public:
 	void UpdateSystems( void );
 	void ClearSystems( void );
 	void SortSystems( void );
+
+	CParticleArena	m_Arena;
 private:
 	CParticleSystem	*m_pFirstSystem;
 };
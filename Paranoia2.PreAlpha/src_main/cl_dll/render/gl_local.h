@@ -639,6 +639,8 @@ typedef struct
 	unsigned int	c_view_beams_count;
 	unsigned int	c_active_tents_count;
 	unsigned int	c_studio_models_drawn;
+	unsigned int	c_studio_poses_computed;
+	unsigned int	c_studio_poses_cached;	// reused from the instance pose cache
 	unsigned int	c_sprite_models_drawn;
 	unsigned int	c_particle_count;
 
@@ -1286,6 +1286,10 @@ void HUD_PrintStats( void )
 		Q_snprintf( r_speeds_msg, sizeof( r_speeds_msg ), "DIP count %3i\nShader bind %3i",
 		r_stats.num_flushes, r_stats.num_shader_binds );
 		break;
+	case 4:
+		Q_snprintf( r_speeds_msg, sizeof( r_speeds_msg ), "%3i studio models\n%3i poses computed\n%3i poses cached",
+		r_stats.c_studio_models_drawn, r_stats.c_studio_poses_computed, r_stats.c_studio_poses_cached );
+		break;
 	case 5:
 		Q_snprintf( r_speeds_msg, sizeof( r_speeds_msg ), "%3i tempents\n%3i viewbeams\n%3i particles",
 		r_stats.c_active_tents_count, r_stats.c_view_beams_count, r_stats.c_particle_count );
@@ -28,49 +28,58 @@ GNU General Public License for more details.
 
 CQuakePartSystem	g_pParticles;
 
-bool CQuakePart :: Evaluate( float gravity )
+/*
+=================
+PointContents
+
+particles are spawned in clusters from the
+same origin, so the contents are cached per
+frame for the exact points
+=================
+*/
+int CQuakePartSystem :: PointContents( const Vector &point )
 {
-	float	curAlpha, curRadius, curLength;
-	Vector	curColor, curOrigin, lastOrigin, curVelocity;
-	float	time, time2;
+	partcontents_t	*pCache;
+	const unsigned int	*bits = (const unsigned int *)&point.x;
 
-	time = RI.refdef.time - flTime;
-	time2 = time * time;
+	int hash = (( bits[0] * 73856093 ) ^ ( bits[1] * 19349663 ) ^ ( bits[2] * 83492791 )) & (PART_CONTENTS_HASH - 1);
+	pCache = &m_contentsCache[hash];
 
-	curAlpha = alpha + alphaVelocity * time;
-	curRadius = radius + radiusVelocity * time;
-	curLength = length + lengthVelocity * time;
+	if( pCache->framecount == m_iContentsFrame && pCache->point == point )
+		return pCache->contents;
 
-	if( curAlpha <= 0.0f || curRadius <= 0.0f || curLength <= 0.0f )
-	{
-		// faded out
-		return false;
-	}
+	pCache->point = point;
+	pCache->contents = POINT_CONTENTS( point );
+	pCache->framecount = m_iContentsFrame;
 
-	curColor = color + colorVelocity * time;
+	return pCache->contents;
+}
 
-	curOrigin.x = origin.x + velocity.x * time + accel.x * time2;
-	curOrigin.y = origin.y + velocity.y * time + accel.y * time2;
-	curOrigin.z = origin.z + velocity.z * time + accel.z * time2 * gravity;
+bool CQuakePartSystem :: Evaluate( int i, float gravity )
+{
+	Vector	&origin = m_origin[i];
+	Vector	&oldorigin = m_oldorigin[i];
+	Vector	&velocity = m_velocity[i];
+	Vector	&accel = m_accel[i];
+	Vector	&curColor = m_curColor[i];
+	Vector	&curOrigin = m_curOrigin[i];
+	float	&curAlpha = m_curAlpha[i];
+	float	&curRadius = m_curRadius[i];
+	float	&curLength = m_curLength[i];
+	int	&flags = m_flags[i];
+	Vector	lastOrigin, curVelocity;
+	float	time;
 
-	if( FBitSet( flags, FPART_UNDERWATER ))
+	if( curAlpha <= 0.0f || curRadius <= 0.0f || curLength <= 0.0f )
 	{
-		// underwater particle
-		lastOrigin.Init( curOrigin.x, curOrigin.y, curOrigin.z + curRadius );
-
-		int contents = POINT_CONTENTS( lastOrigin );
-
-		if( contents != CONTENTS_WATER && contents != CONTENTS_SLIME && contents != CONTENTS_LAVA )
-		{
-			// not underwater
-			return false;
-		}
+		// faded out or underwater particle is left the water
+		return false;
 	}
 
 	if( FBitSet( flags, FPART_FRICTION ))
 	{
 		// water friction affected particle
-		int contents = POINT_CONTENTS( curOrigin );
+		int contents = m_curContents[i];
 
 		if( contents <= CONTENTS_WATER && contents >= CONTENTS_LAVA )
 		{
@@ -96,24 +105,21 @@ bool CQuakePart :: Evaluate( float gravity )
 			curLength = 1.0f;
 				
 			// reset
-			flTime = RI.refdef.time;
+			m_flTime[i] = RI.refdef.time;
 			origin = curOrigin;
-			color = curColor;
-			alpha = curAlpha;
-			radius = curRadius;
+			m_color[i] = curColor;
+			m_alpha[i] = curAlpha;
+			m_radius[i] = curRadius;
 
 			// don't stretch
 			flags &= ~FPART_STRETCH;
-			length = curLength;
-			lengthVelocity = 0.0f;
+			m_length[i] = curLength;
+			m_lengthVelocity[i] = 0.0f;
 		}
 	}
 
 	if( FBitSet( flags, FPART_BOUNCE ))
 	{
-		Vector	mins( -radius, -radius, -radius );
-		Vector	maxs(  radius,  radius,  radius );
-
 		// bouncy particle
 		pmtrace_t pmtrace;
 		gEngfuncs.pEventAPI->EV_SetTraceHull( 2 );
@@ -123,7 +129,7 @@ bool CQuakePart :: Evaluate( float gravity )
 		{
 			// reflect velocity
 			time = RI.refdef.time - (RI.refdef.frametime + RI.refdef.frametime * pmtrace.fraction);
-			time = (time - flTime);
+			time = (time - m_flTime[i]);
 
 			curVelocity.x = velocity.x;
 			curVelocity.y = velocity.y;
@@ -131,7 +137,7 @@ bool CQuakePart :: Evaluate( float gravity )
 
 			float d = DotProduct( curVelocity, pmtrace.plane.normal ) * -1.0f;
 			velocity = curVelocity + pmtrace.plane.normal * d;
-			velocity *= bounceFactor;
+			velocity *= m_bounceFactor[i];
 
 			// check for stop or slide along the plane
 			if( pmtrace.plane.normal.z > 0 && velocity.z < 1.0f )
@@ -157,16 +163,16 @@ bool CQuakePart :: Evaluate( float gravity )
 			curLength = 1;
 
 			// reset
-			flTime = RI.refdef.time;
+			m_flTime[i] = RI.refdef.time;
 			origin = curOrigin;
-			color = curColor;
-			alpha = curAlpha;
-			radius = curRadius;
+			m_color[i] = curColor;
+			m_alpha[i] = curAlpha;
+			m_radius[i] = curRadius;
 
 			// don't stretch
 			flags &= ~FPART_STRETCH;
-			length = curLength;
-			lengthVelocity = 0.0f;
+			m_length[i] = curLength;
+			m_lengthVelocity[i] = 0.0f;
 		}
 	}
 	
@@ -189,8 +195,8 @@ bool CQuakePart :: Evaluate( float gravity )
 	if( FBitSet( flags, FPART_INSTANT ))
 	{
 		// instant particle
-		alpha = 0.0f;
-		alphaVelocity = 0.0f;
+		m_alpha[i] = 0.0f;
+		m_alphaVelocity[i] = 0.0f;
 	}
 
 	if( curRadius == 1.0f )
@@ -225,7 +231,7 @@ bool CQuakePart :: Evaluate( float gravity )
 		axis[0] = axis[0].Normalize();
 
 		oldorigin = origin + ( axis[1] * -curLength );
-		axis[2] *= radius;
+		axis[2] *= m_radius[i];
 
 		// setup vertexes
 		verts[0] = lastOrigin + axis[2];
@@ -235,10 +241,10 @@ bool CQuakePart :: Evaluate( float gravity )
 	}
 	else
 	{
-		if( rotation )
+		if( m_rotation[i] )
 		{
 			// Rotate it around its normal
-			RotatePointAroundVector( axis[1], RI.vforward, RI.vright, rotation );
+			RotatePointAroundVector( axis[1], RI.vforward, RI.vright, m_rotation[i] );
 			axis[2] = CrossProduct( RI.vforward, axis[1] );
 
 			// the normal should point at the viewer
@@ -264,49 +270,71 @@ bool CQuakePart :: Evaluate( float gravity )
 		verts[3] = curOrigin + axis[1] - axis[2];
 	}
 
-	// draw the particle
-	GL_Bind( GL_TEXTURE0, m_hTexture );
+	DrawParticle( i, verts );
+
+	return true;
+}
 
-	pglEnable( GL_BLEND );
-//	pglEnable( GL_ALPHA_TEST );
-//	pglAlphaFunc( GL_GREATER, 0.0f );
-	if( FBitSet( flags, FPART_ADDITIVE ))
-		pglBlendFunc( GL_SRC_ALPHA, GL_ONE );
-	else pglBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-	pglTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
 /*
-	pglTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE_ARB );
-	pglTexEnvi( GL_TEXTURE_ENV, GL_COMBINE_RGB_ARB, GL_MODULATE );
-	pglTexEnvi( GL_TEXTURE_ENV, GL_SOURCE0_RGB_ARB, GL_PREVIOUS_ARB );
-	pglTexEnvi( GL_TEXTURE_ENV, GL_SOURCE1_RGB_ARB, GL_TEXTURE );
-	pglTexEnvi( GL_TEXTURE_ENV, GL_RGB_SCALE_ARB, 2 );
+=================
+DrawParticle
+
+particles with the same texture and
+blending are drawn with one glBegin
+=================
 */
-	if( FBitSet( flags, FPART_ADDITIVE )) pglColor4f( 1.0f, 1.0f, 1.0f, curAlpha );
-	else pglColor4f( curColor.x, curColor.y, curColor.z, curAlpha );
+void CQuakePartSystem :: DrawParticle( int i, const Vector verts[4] )
+{
+	int flags = FBitSet( m_flags[i], FPART_ADDITIVE );
 
-	pglBegin( GL_QUADS );
-		pglTexCoord2f( 0.0f, 0.0f );
-		pglVertex3fv( verts[0] );
+	if( !m_fInBatch || m_hBatchTexture != m_hTexture[i] || m_iBatchFlags != flags )
+	{
+		EndBatch();
 
-		pglTexCoord2f( 1.0f, 0.0f );
-		pglVertex3fv( verts[1] );
+		GL_Bind( GL_TEXTURE0, m_hTexture[i] );
 
-		pglTexCoord2f( 1.0f, 1.0f );
-		pglVertex3fv( verts[2] );
+		pglEnable( GL_BLEND );
+		if( flags ) pglBlendFunc( GL_SRC_ALPHA, GL_ONE );
+		else pglBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+		pglTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE );
 
-		pglTexCoord2f( 0.0f, 1.0f );
-		pglVertex3fv( verts[3] );
-	pglEnd();
+		pglBegin( GL_QUADS );
+		m_hBatchTexture = m_hTexture[i];
+		m_iBatchFlags = flags;
+		m_fInBatch = true;
+	}
 
-	return true;
+	if( flags ) pglColor4f( 1.0f, 1.0f, 1.0f, m_curAlpha[i] );
+	else pglColor4f( m_curColor[i].x, m_curColor[i].y, m_curColor[i].z, m_curAlpha[i] );
+
+	pglTexCoord2f( 0.0f, 0.0f );
+	pglVertex3fv( verts[0] );
+
+	pglTexCoord2f( 1.0f, 0.0f );
+	pglVertex3fv( verts[1] );
+
+	pglTexCoord2f( 1.0f, 1.0f );
+	pglVertex3fv( verts[2] );
+
+	pglTexCoord2f( 0.0f, 1.0f );
+	pglVertex3fv( verts[3] );
 }
 
-CQuakePartSystem :: CQuakePartSystem( void )
+void CQuakePartSystem :: EndBatch( void )
 {
-	memset( m_pParticles, 0, sizeof( CQuakePart ) * MAX_PARTICLES );
+	if( !m_fInBatch )
+		return;
 
-	m_pFreeParticles = m_pParticles;
-	m_pActiveParticles = NULL;
+	pglEnd();
+	m_fInBatch = false;
+}
+
+CQuakePartSystem :: CQuakePartSystem( void )
+{
+	memset( m_contentsCache, 0, sizeof( m_contentsCache ));
+	m_iContentsFrame = 0;
+	m_iNumParticles = 0;
+	m_fInBatch = false;
 }
 
 CQuakePartSystem :: ~CQuakePartSystem( void )
@@ -315,13 +343,9 @@ CQuakePartSystem :: ~CQuakePartSystem( void )
 
 void CQuakePartSystem :: Clear( void )
 {
-	m_pFreeParticles = m_pParticles;
-	m_pActiveParticles = NULL;
-
-	for( int i = 0; i < MAX_PARTICLES; i++ )
-		m_pParticles[i].next = &m_pParticles[i+1];
-
-	m_pParticles[MAX_PARTICLES-1].next = NULL;
+	memset( m_contentsCache, 0, sizeof( m_contentsCache ));
+	m_iContentsFrame = 0;
+	m_iNumParticles = 0;
 
 	m_pAllowParticles = CVAR_REGISTER( "cl_particles", "1", FCVAR_ARCHIVE );
 	m_pParticleLod = CVAR_REGISTER( "cl_particle_lod", "0", FCVAR_ARCHIVE );
@@ -333,105 +357,157 @@ void CQuakePartSystem :: Clear( void )
 	m_hWaterSplash = LOAD_TEXTURE( "gfx/particles/splash1.tga", NULL, 0, TF_NOPICMIP|TF_CLAMP );
 }
 
-void CQuakePartSystem :: FreeParticle( CQuakePart *pCur )
+// move the last particle into the freed slot
+void CQuakePartSystem :: FreeParticle( int i )
 {
-	pCur->next = m_pFreeParticles;
-	m_pFreeParticles = pCur;
+	int last = --m_iNumParticles;
+
+	if( i == last ) return;
+
+	m_origin[i] = m_origin[last];
+	m_oldorigin[i] = m_oldorigin[last];
+	m_velocity[i] = m_velocity[last];
+	m_accel[i] = m_accel[last];
+	m_color[i] = m_color[last];
+	m_colorVelocity[i] = m_colorVelocity[last];
+	m_alpha[i] = m_alpha[last];
+	m_alphaVelocity[i] = m_alphaVelocity[last];
+	m_radius[i] = m_radius[last];
+	m_radiusVelocity[i] = m_radiusVelocity[last];
+	m_length[i] = m_length[last];
+	m_lengthVelocity[i] = m_lengthVelocity[last];
+	m_rotation[i] = m_rotation[last];
+	m_bounceFactor[i] = m_bounceFactor[last];
+	m_flTime[i] = m_flTime[last];
+	m_flags[i] = m_flags[last];
+	m_hTexture[i] = m_hTexture[last];
+
+	m_curOrigin[i] = m_curOrigin[last];
+	m_curColor[i] = m_curColor[last];
+	m_curAlpha[i] = m_curAlpha[last];
+	m_curRadius[i] = m_curRadius[last];
+	m_curLength[i] = m_curLength[last];
+	m_curContents[i] = m_curContents[last];
 }
 
-CQuakePart *CQuakePartSystem :: AllocParticle( void )
+int CQuakePartSystem :: AllocParticle( void )
 {
-	CQuakePart	*p;
-
-	if( !m_pFreeParticles )
+	if( m_iNumParticles >= MAX_PARTICLES )
 	{
 		ALERT( at_console, "Overflow %d particles\n", MAX_PARTICLES );
-		return NULL;
+		return -1;
 	}
 
 	if( m_pParticleLod->value > 1.0f )
 	{
 		if( !( RANDOM_LONG( 0, 1 ) % (int)m_pParticleLod->value ))
-			return NULL;
+			return -1;
 	}
 
-	p = m_pFreeParticles;
-	m_pFreeParticles = p->next;
-	p->next = m_pActiveParticles;
-	m_pActiveParticles = p;
-
-	return p;
+	return m_iNumParticles++;
 }
 	
 void CQuakePartSystem :: Update( void )
 {
-	CQuakePart	*p, *next;
-	CQuakePart	*active = NULL, *tail = NULL;
+	int	i;
 
 	if( !m_pAllowParticles->value )
 		return;
 
 	float gravity = RI.refdef.frametime * RI.refdef.movevars->gravity;
 
-	for( p = m_pActiveParticles; p; p = next )
+	// move all the particles at once
+	for( i = 0; i < m_iNumParticles; i++ )
 	{
-		// grab next now, so if the particle is freed we still have it
-		next = p->next;
+		float time = RI.refdef.time - m_flTime[i];
+		float time2 = time * time;
 
-		if( !p->Evaluate( gravity ))
-		{
-			FreeParticle( p );
+		m_curAlpha[i] = m_alpha[i] + m_alphaVelocity[i] * time;
+		m_curRadius[i] = m_radius[i] + m_radiusVelocity[i] * time;
+		m_curLength[i] = m_length[i] + m_lengthVelocity[i] * time;
+
+		m_curColor[i].x = m_color[i].x + m_colorVelocity[i].x * time;
+		m_curColor[i].y = m_color[i].y + m_colorVelocity[i].y * time;
+		m_curColor[i].z = m_color[i].z + m_colorVelocity[i].z * time;
+
+		m_curOrigin[i].x = m_origin[i].x + m_velocity[i].x * time + m_accel[i].x * time2;
+		m_curOrigin[i].y = m_origin[i].y + m_velocity[i].y * time + m_accel[i].y * time2;
+		m_curOrigin[i].z = m_origin[i].z + m_velocity[i].z * time + m_accel[i].z * time2 * gravity;
+	}
+
+	// now the contents for underwater and friction particles
+	m_iContentsFrame++;
+
+	for( i = 0; i < m_iNumParticles; i++ )
+	{
+		if( !FBitSet( m_flags[i], FPART_UNDERWATER|FPART_FRICTION ))
 			continue;
-		}
 
-		p->next = NULL;
+		if( m_curAlpha[i] <= 0.0f || m_curRadius[i] <= 0.0f || m_curLength[i] <= 0.0f )
+			continue; // faded out
 
-		if( !tail )
+		if( FBitSet( m_flags[i], FPART_UNDERWATER ))
 		{
-			active = tail = p;
+			// underwater particle
+			Vector top( m_curOrigin[i].x, m_curOrigin[i].y, m_curOrigin[i].z + m_curRadius[i] );
+			int contents = PointContents( top );
+
+			if( contents != CONTENTS_WATER && contents != CONTENTS_SLIME && contents != CONTENTS_LAVA )
+			{
+				// not underwater
+				m_curAlpha[i] = 0.0f;
+				continue;
+			}
 		}
-		else
+
+		if( FBitSet( m_flags[i], FPART_FRICTION ))
+			m_curContents[i] = PointContents( m_curOrigin[i] );
+	}
+
+	for( i = 0; i < m_iNumParticles; )
+	{
+		if( !Evaluate( i, gravity ))
 		{
-			tail->next = p;
-			tail = p;
+			// last particle is moved here, so evaluate this slot again
+			FreeParticle( i );
+			continue;
 		}
+		i++;
 	}
 
-	m_pActiveParticles = active;
+	EndBatch();
 }
 
 bool CQuakePartSystem :: AddParticle( CQuakePart *src, int texture, int flags )
 {
 	if( !src ) return false;
 
-	CQuakePart *dst = AllocParticle();
-
-	if( !dst ) return false;
-
-	if( texture ) dst->m_hTexture = texture;
-	else dst->m_hTexture = m_hDefaultParticle;
-	dst->flTime = RI.refdef.time;
-	dst->flags = flags;
-
-	dst->origin = src->origin;
-	dst->velocity = src->velocity;
-	dst->accel = src->accel; 
-	dst->color = src->color;
-	dst->colorVelocity = src->colorVelocity;
-	dst->alpha = src->alpha;
-	dst->scale = 1.0f;
-
-	dst->radius = src->radius;
-	dst->length = src->length;
-	dst->rotation = src->rotation;
-	dst->alphaVelocity = src->alphaVelocity;
-	dst->radiusVelocity = src->radiusVelocity;
-	dst->lengthVelocity = src->lengthVelocity;
-	dst->bounceFactor = src->bounceFactor;
-
-	// needs to save old origin
-	if( FBitSet( flags, ( FPART_BOUNCE|FPART_FRICTION )))
-		dst->oldorigin = dst->origin;
+	int i = AllocParticle();
+
+	if( i == -1 ) return false;
+
+	if( texture ) m_hTexture[i] = texture;
+	else m_hTexture[i] = m_hDefaultParticle;
+	m_flTime[i] = RI.refdef.time;
+	m_flags[i] = flags;
+
+	m_origin[i] = src->origin;
+	m_velocity[i] = src->velocity;
+	m_accel[i] = src->accel; 
+	m_color[i] = src->color;
+	m_colorVelocity[i] = src->colorVelocity;
+	m_alpha[i] = src->alpha;
+
+	m_radius[i] = src->radius;
+	m_length[i] = src->length;
+	m_rotation[i] = src->rotation;
+	m_alphaVelocity[i] = src->alphaVelocity;
+	m_radiusVelocity[i] = src->radiusVelocity;
+	m_lengthVelocity[i] = src->lengthVelocity;
+	m_bounceFactor[i] = src->bounceFactor;
+
+	// slot may keep the old origin of a freed particle
+	m_oldorigin[i] = m_origin[i];
 
 	return true;
 }
@@ -17,7 +17,10 @@ GNU General Public License for more details.
 #ifndef GL_RPART_H
 #define GL_RPART_H
 
-#define MAX_PARTICLES		8192
+#define MAX_PARTICLES		32768
+
+// point contents are cached per frame for the exact points
+#define PART_CONTENTS_HASH		1024	// must be a power of two
 
 // built-in particle-system flags
 #define FPART_BOUNCE		(1<<0)	// makes a bouncy particle
@@ -28,6 +31,7 @@ GNU General Public License for more details.
 #define FPART_INSTANT		(1<<5)
 #define FPART_ADDITIVE		(1<<6)
 
+// particle description for AddParticle
 class CQuakePart
 {
 public:
@@ -47,21 +51,54 @@ public:
 	float		rotation;		// texture ROLL angle
 	float		bounceFactor;
 	float		scale;
-
-	CQuakePart	*next;		// linked list
-	int		m_hTexture;
-
-	float		flTime;
-	int		flags;
-
-	bool		Evaluate( float gravity );
 };
 
+typedef struct
+{
+	Vector		point;
+	int		contents;
+	int		framecount;
+} partcontents_t;
+
 class CQuakePartSystem
 {
-	CQuakePart	*m_pActiveParticles;
-	CQuakePart	*m_pFreeParticles;
-	CQuakePart	m_pParticles[MAX_PARTICLES];
+	// particles are kept as the structure of arrays, active ones are [0, m_iNumParticles)
+	// and a dead particle is replaced with the last one, so the loops run over dense arrays
+	int		m_iNumParticles;
+
+	Vector		m_origin[MAX_PARTICLES];
+	Vector		m_oldorigin[MAX_PARTICLES];
+	Vector		m_velocity[MAX_PARTICLES];
+	Vector		m_accel[MAX_PARTICLES];
+	Vector		m_color[MAX_PARTICLES];
+	Vector		m_colorVelocity[MAX_PARTICLES];
+	float		m_alpha[MAX_PARTICLES];
+	float		m_alphaVelocity[MAX_PARTICLES];
+	float		m_radius[MAX_PARTICLES];
+	float		m_radiusVelocity[MAX_PARTICLES];
+	float		m_length[MAX_PARTICLES];
+	float		m_lengthVelocity[MAX_PARTICLES];
+	float		m_rotation[MAX_PARTICLES];
+	float		m_bounceFactor[MAX_PARTICLES];
+	float		m_flTime[MAX_PARTICLES];
+	int		m_flags[MAX_PARTICLES];
+	int		m_hTexture[MAX_PARTICLES];
+
+	// values for current frame
+	Vector		m_curOrigin[MAX_PARTICLES];
+	Vector		m_curColor[MAX_PARTICLES];
+	float		m_curAlpha[MAX_PARTICLES];
+	float		m_curRadius[MAX_PARTICLES];
+	float		m_curLength[MAX_PARTICLES];
+	int		m_curContents[MAX_PARTICLES];	// for friction particles
+
+	partcontents_t	m_contentsCache[PART_CONTENTS_HASH];
+	int		m_iContentsFrame;
+
+	// current quads batch
+	int		m_hBatchTexture;
+	int		m_iBatchFlags;
+	bool		m_fInBatch;
 
 	// private partsystem shaders
 	int		m_hDefaultParticle;
@@ -71,14 +108,19 @@ class CQuakePartSystem
 
 	cvar_t		*m_pAllowParticles;
 	cvar_t		*m_pParticleLod;
+
+	int		PointContents( const Vector &point );
+	bool		Evaluate( int i, float gravity );
+	void		DrawParticle( int i, const Vector verts[4] );
+	void		EndBatch( void );
 public:
 			CQuakePartSystem( void );
 	virtual		~CQuakePartSystem( void );
 
 	void		Clear( void );
 	void		Update( void );
-	void		FreeParticle( CQuakePart *pCur );
-	CQuakePart	*AllocParticle( void );
+	void		FreeParticle( int i );
+	int		AllocParticle( void );
 	bool		AddParticle( CQuakePart *src, int texture = 0, int flags = 0 );
 
 	// example presets
@@ -181,6 +181,7 @@ word CStudioModelRenderer :: CreateInstance( cl_entity_t *pEnt )
 	m_ModelInstances[handle].m_pModel = m_pRenderModel;
 	m_ModelInstances[handle].m_DecalCount = 0;
 	m_ModelInstances[handle].cached_frame = -1;
+	m_ModelInstances[handle].m_bPoseValid = false;
 	memset( m_ModelInstances[handle].m_protationmatrix, 0, sizeof( matrix3x4 ));
 	memset( m_ModelInstances[handle].m_pbones, 0, sizeof( matrix3x4 ) * MAXSTUDIOBONES );
 	memset( m_ModelInstances[handle].m_pwpnbones, 0, sizeof( matrix3x4 ) * MAXSTUDIOBONES );
@@ -1440,17 +1441,7 @@ StudioSlerpBones
 */
 void CStudioModelRenderer :: StudioSlerpBones( Vector4D q1[], Vector pos1[], Vector4D q2[], Vector pos2[], float s )
 {
-	float	s1;
-
-	// clamp the frac
-	s = bound( 0.0f, s, 1.0f );
-	s1 = 1.0f - s;
-
-	for( int i = 0; i < m_pStudioHeader->numbones; i++ )
-	{
-		QuaternionSlerp( q1[i], q2[i], s, q1[i] );
-		InterpolateOrigin( pos1[i], pos2[i], pos1[i], s );
-	}
+	QuaternionSlerpBones( q1, pos1, q2, pos2, s, m_pStudioHeader->numbones );
 }
 
 /*
@@ -1511,36 +1502,24 @@ void CStudioModelRenderer :: StudioCalcRotations( Vector pos[], Vector4D q[], ms
 
 /*
 ====================
-StudioSetupBones
+StudioCalcPose
 
+local bone positions and rotations
+for current animation state
 ====================
 */
-void CStudioModelRenderer :: StudioSetupBones( matrix3x4 &transform, matrix3x4 bonetransform[] )
+void CStudioModelRenderer :: StudioCalcPose( Vector pos[], Vector4D q[], mstudioseqdesc_t *pseqdesc, float f )
 {
-	mstudiobone_t	*pbones;
-	mstudioseqdesc_t	*pseqdesc;
 	mstudioanim_t	*panim;
-	matrix3x4		bonematrix;
 
-	static Vector	pos[MAXSTUDIOBONES];
-	static Vector4D	q[MAXSTUDIOBONES];
-	static Vector	pos2[MAXSTUDIOBONES];
-	static Vector4D	q2[MAXSTUDIOBONES];
-	static Vector	pos3[MAXSTUDIOBONES];
-	static Vector4D	q3[MAXSTUDIOBONES];
-	static Vector	pos4[MAXSTUDIOBONES];
-	static Vector4D	q4[MAXSTUDIOBONES];
+	// scratch space is on the stack, so the function is reentrant
+	Vector		pos2[MAXSTUDIOBONES];
+	Vector4D		q2[MAXSTUDIOBONES];
+	Vector		pos3[MAXSTUDIOBONES];
+	Vector4D		q3[MAXSTUDIOBONES];
+	Vector		pos4[MAXSTUDIOBONES];
+	Vector4D		q4[MAXSTUDIOBONES];
 
-	if( m_pCurrentEntity->curstate.sequence < 0 || m_pCurrentEntity->curstate.sequence >= m_pStudioHeader->numseq ) 
-	{
-		int sequence = (short)m_pCurrentEntity->curstate.sequence;
-		ALERT( at_warning, "StudioSetupBones: sequence %i/%i out of range for model %s\n", sequence, m_pStudioHeader->numseq, m_pRenderModel->name );
-		m_pCurrentEntity->curstate.sequence = 0;
-          }
-
-	pseqdesc = (mstudioseqdesc_t *)((byte *)m_pStudioHeader + m_pStudioHeader->seqindex) + m_pCurrentEntity->curstate.sequence;
-
-	float f = StudioEstimateFrame( pseqdesc );
 	panim = StudioGetAnim( m_pRenderModel, pseqdesc );
 	StudioCalcRotations( pos, q, pseqdesc, panim, f );
 
@@ -1574,8 +1553,8 @@ void CStudioModelRenderer :: StudioSetupBones( matrix3x4 &transform, matrix3x4 b
 	
 	if( m_fDoInterp && m_pCurrentEntity->latched.sequencetime && ( m_pCurrentEntity->latched.sequencetime + 0.2f > m_clTime ) && ( m_pCurrentEntity->latched.prevsequence < m_pStudioHeader->numseq ))
 	{
-		static Vector	pos1b[MAXSTUDIOBONES];
-		static Vector4D	q1b[MAXSTUDIOBONES];
+		Vector		pos1b[MAXSTUDIOBONES];
+		Vector4D		q1b[MAXSTUDIOBONES];
 		float		s;
 
 		// blend from last sequence
@@ -1618,11 +1597,11 @@ void CStudioModelRenderer :: StudioSetupBones( matrix3x4 &transform, matrix3x4 b
 		m_pCurrentEntity->latched.prevframe = f;
 	}
 
-	pbones = (mstudiobone_t *)((byte *)m_pStudioHeader + m_pStudioHeader->boneindex);
-
 	// calc gait animation
 	if( m_pPlayerInfo && m_pPlayerInfo->gaitsequence != 0 )
 	{
+		mstudiobone_t *pbones = (mstudiobone_t *)((byte *)m_pStudioHeader + m_pStudioHeader->boneindex);
+
 		if( m_pPlayerInfo->gaitsequence < 0 || m_pPlayerInfo->gaitsequence >= m_pStudioHeader->numseq ) 
 			m_pPlayerInfo->gaitsequence = 0;
 
@@ -1646,6 +1625,104 @@ void CStudioModelRenderer :: StudioSetupBones( matrix3x4 &transform, matrix3x4 b
 			q[i] = q2[i];
 		}
 	}
+}
+
+/*
+====================
+StudioPoseKey
+
+====================
+*/
+bool CStudioModelRenderer :: StudioPoseKey( studioposekey_t *key, float f )
+{
+	cl_entity_t *e = m_pCurrentEntity;
+
+	memset( key, 0, sizeof( *key ));
+
+	// blending from the last sequence is changed every frame
+	if( m_fDoInterp && e->latched.sequencetime && ( e->latched.sequencetime + 0.2f > m_clTime ) && ( e->latched.prevsequence < m_pStudioHeader->numseq ))
+		return false;
+
+	// gait sequence is not a part of the key
+	if( m_pPlayerInfo && m_pPlayerInfo->gaitsequence != 0 )
+		return false;
+
+	key->model = m_pRenderModel;
+	key->sequence = e->curstate.sequence;
+	key->renderfx = e->curstate.renderfx;
+	key->frame = f;
+	key->mouthopen = e->mouth.mouthopen;
+	memcpy( key->blending, e->curstate.blending, sizeof( key->blending ));
+	memcpy( key->prevblending, e->latched.prevblending, sizeof( key->prevblending ));
+	memcpy( key->controller, e->curstate.controller, sizeof( key->controller ));
+	memcpy( key->prevcontroller, e->latched.prevcontroller, sizeof( key->prevcontroller ));
+
+	// interpolant is used only to lerp the latched values
+	if( memcmp( key->blending, key->prevblending, sizeof( key->blending )) || memcmp( key->controller, key->prevcontroller, sizeof( key->controller )))
+		key->dadt = StudioEstimateInterpolant();
+
+	return true;
+}
+
+/*
+====================
+StudioSetupBones
+
+====================
+*/
+void CStudioModelRenderer :: StudioSetupBones( matrix3x4 &transform, matrix3x4 bonetransform[] )
+{
+	ModelInstance_t	*inst = m_pModelInstance;
+	mstudiobone_t	*pbones;
+	mstudioseqdesc_t	*pseqdesc;
+	matrix3x4		bonematrix;
+	studioposekey_t	key;
+	Vector		pos[MAXSTUDIOBONES];
+	Vector4D		q[MAXSTUDIOBONES];
+
+	if( m_pCurrentEntity->curstate.sequence < 0 || m_pCurrentEntity->curstate.sequence >= m_pStudioHeader->numseq ) 
+	{
+		int sequence = (short)m_pCurrentEntity->curstate.sequence;
+		ALERT( at_warning, "StudioSetupBones: sequence %i/%i out of range for model %s\n", sequence, m_pStudioHeader->numseq, m_pRenderModel->name );
+		m_pCurrentEntity->curstate.sequence = 0;
+          }
+
+	pseqdesc = (mstudioseqdesc_t *)((byte *)m_pStudioHeader + m_pStudioHeader->seqindex) + m_pCurrentEntity->curstate.sequence;
+
+	float f = StudioEstimateFrame( pseqdesc );
+
+	// pose cache is kept only for the drawn instances
+	if( inst && ( inst->m_pEntity != m_pCurrentEntity || inst->m_pModel != m_pRenderModel ))
+		inst = NULL;
+
+	bool cacheable = StudioPoseKey( &key, f );
+
+	if( inst && cacheable && inst->m_bPoseValid && !memcmp( &inst->m_PoseKey, &key, sizeof( key )))
+	{
+		memcpy( pos, inst->m_posepos, sizeof( Vector ) * m_pStudioHeader->numbones );
+		memcpy( q, inst->m_poseq, sizeof( Vector4D ) * m_pStudioHeader->numbones );
+		m_pCurrentEntity->latched.prevframe = f;
+		r_stats.c_studio_poses_cached++;
+	}
+	else
+	{
+		StudioCalcPose( pos, q, pseqdesc, f );
+		r_stats.c_studio_poses_computed++;
+
+		if( inst )
+		{
+			inst->m_bPoseValid = cacheable;
+
+			if( cacheable )
+			{
+				inst->m_PoseKey = key;
+				memcpy( inst->m_posepos, pos, sizeof( Vector ) * m_pStudioHeader->numbones );
+				memcpy( inst->m_poseq, q, sizeof( Vector4D ) * m_pStudioHeader->numbones );
+			}
+		}
+	}
+
+	pbones = (mstudiobone_t *)((byte *)m_pStudioHeader + m_pStudioHeader->boneindex);
 
 	for( int i = 0; i < m_pStudioHeader->numbones; i++ ) 
 	{
@@ -1691,8 +1768,8 @@ void CStudioModelRenderer :: StudioMergeBones( matrix3x4 &transform, matrix3x4 b
 {
 	mstudioanim_t	*panim;
 	matrix3x4		bonematrix;
-	static Vector	pos[MAXSTUDIOBONES];
-	static Vector4D	q[MAXSTUDIOBONES];
+	Vector		pos[MAXSTUDIOBONES];
+	Vector4D		q[MAXSTUDIOBONES];
 	int		sequence = m_pCurrentEntity->curstate.sequence;
 
 	ASSERT( pModel != NULL && pModel->type == mod_studio );
@@ -2402,7 +2479,7 @@ void CStudioModelRenderer :: AddDecalToModel( DecalBuildInfo_t& buildInfo )
 //-----------------------------------------------------------------------------
 bool CStudioModelRenderer :: IsModelInstanceValid( word handle )
 {
-	ModelInstance_t inst = m_ModelInstances[handle];
+	ModelInstance_t &inst = m_ModelInstances[handle];
 	const model_t *pModel;
 
 	if( !m_fDrawViewModel && UTIL_IsPlayer( inst.m_pEntity->curstate.number ))
@@ -144,6 +144,22 @@ typedef struct xvert_s
 	byte		color[4];		// padding for now
 } xvert_t;
 
+// animation state of the local bone pose. Cleared with memset
+// before filling, so the keys can be compared with memcmp
+typedef struct
+{
+	model_t		*model;
+	int		sequence;
+	int		renderfx;		// 51 disables the controllers interpolation
+	float		frame;
+	float		dadt;		// only when the blending or controllers are interpolated
+	byte		blending[2];
+	byte		prevblending[2];
+	byte		controller[4];
+	byte		prevcontroller[4];
+	byte		mouthopen;
+} studioposekey_t;
+
 /*
 ====================
 CStudioModelRenderer
@@ -183,6 +199,12 @@ public:
 	// Set up model bone positions
 	virtual void StudioSetupBones( matrix3x4 &transform, matrix3x4 bonetransform[] );	
 
+	// Compute local bone positions and rotations for current animation state
+	virtual void StudioCalcPose( Vector pos[], Vector4D q[], mstudioseqdesc_t *pseqdesc, float f );
+
+	// Fill the pose cache key, returns false if the pose can't be cached
+	virtual bool StudioPoseKey( studioposekey_t *key, float f );
+
 	// Find final attachment points
 	virtual void StudioCalcAttachments( matrix3x4 bones[] );
 	
@@ -318,6 +340,12 @@ public:
 		GLfloat		m_glbones[MAXSTUDIOBONES][16];
 		GLfloat		m_glwpnbones[MAXSTUDIOBONES][16];	// used for p_models on player or NPC
 		unsigned int	cached_frame;	// to avoid compute bones more than once per frame
+
+		// local bone pose, reused while the animation state is the same (e.g. paused or static models)
+		studioposekey_t	m_PoseKey;
+		bool		m_bPoseValid;
+		Vector		m_posepos[MAXSTUDIOBONES];
+		Vector4D		m_poseq[MAXSTUDIOBONES];
 	};
 
 	struct Decal_t
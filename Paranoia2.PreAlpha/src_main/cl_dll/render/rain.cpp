@@ -25,6 +25,7 @@ MemBlock<cl_drip>	g_dripsArray( MAXDRIPS );
 MemBlock<cl_rainfx>	g_fxArray( MAXFX );
 
 cvar_t		*cl_debug_rain = NULL;
+cvar_t		*cl_rain_heightfield = NULL;
 
 double		rain_curtime;	// current time
 double		rain_oldtime;	// last time we have updated drips
@@ -40,6 +41,125 @@ static Vector2D	m_coordsarray[MAX_RAIN_VERTICES];
 static word	m_indexarray[MAX_RAIN_INDICES];
 static int	m_iNumVerts, m_iNumIndex;
 
+static raincell_t	rain_field[RAINCELL_GRID][RAINCELL_GRID];
+static rain_properties rain_fieldparms;	// rain settings the field was traced with
+static int	rain_numtraces;		// traces for this second
+static int	rain_numspawns;		// spawn attempts for this second
+static int	rain_tracespersec;
+static int	rain_spawnspersec;
+static double	rain_nextstatstime;
+
+/*
+=================================
+RainTraceDrip
+
+find where a drip falling from vecStart lands
+=================================
+*/
+static void RainTraceDrip( vec3_t vecStart, const vec3_t &vecDelta, raincell_t *cell )
+{
+	pmtrace_t pmtrace;
+
+	gEngfuncs.pEventAPI->EV_SetTraceHull( 2 );
+	gEngfuncs.pEventAPI->EV_PlayerTrace( vecStart, vecStart + vecDelta, PM_STUDIO_IGNORE, -1, &pmtrace );
+	rain_numtraces++;
+
+	cell->time = rain_curtime;
+	cell->waterent = 0;
+
+	if( pmtrace.startsolid || pmtrace.allsolid )
+	{
+		cell->type = RAINCELL_BLOCKED;
+		return;
+	}
+
+	// falling to water?
+	if( gEngfuncs.PM_PointContents( pmtrace.endpos, NULL ) == CONTENTS_WATER )
+	{
+		int waterEntity = WATER_ENTITY( pmtrace.endpos );
+
+		if( waterEntity > 0 )
+		{
+			cl_entity_t *pwater = gEngfuncs.GetEntityByIndex( waterEntity );
+
+			if( pwater && ( pwater->model != NULL ))
+			{
+				cell->height = pwater->curstate.maxs.z - 1.0f;
+				cell->waterent = waterEntity;
+				cell->type = RAINCELL_WATER;
+			}
+			else
+			{
+				ALERT( at_error, "rain: can't get water entity\n" );
+				cell->type = RAINCELL_BLOCKED;
+				return;
+			}
+		}
+		else
+		{
+			ALERT( at_error, "rain: water is not func_water entity\n" );
+			cell->type = RAINCELL_BLOCKED;
+			return;
+		}
+	}
+	else
+	{
+		cell->height = pmtrace.endpos.z;
+		cell->type = RAINCELL_GROUND;
+	}
+
+	// just in case..
+	if( cell->height > vecStart.z )
+	{
+		ALERT( at_error, "rain: can't create drip in water\n");
+		cell->type = RAINCELL_BLOCKED;
+	}
+}
+
+/*
+=================================
+RainGetCell
+
+lookup the occlusion heightfield, texels are traced
+on demand with the mean wind direction
+=================================
+*/
+static raincell_t *RainGetCell( const vec3_t &vecStart, const vec3_t &vecDelta )
+{
+	int x = (int)floor( vecStart.x / RAINCELL_SIZE );
+	int y = (int)floor( vecStart.y / RAINCELL_SIZE );
+	raincell_t *cell = &rain_field[y & (RAINCELL_GRID - 1)][x & (RAINCELL_GRID - 1)];
+
+	if( cell->type != RAINCELL_EMPTY && cell->x == x && cell->y == y )
+	{
+		if(( rain_curtime - cell->time ) < RAINCELL_MAXAGE )
+			return cell;
+	}
+
+	vec3_t vecCell;
+
+	vecCell.x = ( x + 0.5f ) * RAINCELL_SIZE;
+	vecCell.y = ( y + 0.5f ) * RAINCELL_SIZE;
+	vecCell.z = vecStart.z;
+
+	RainTraceDrip( vecCell, vecDelta, cell );
+	cell->x = x;
+	cell->y = y;
+
+	return cell;
+}
+
+/*
+=================================
+RainClearField
+=================================
+*/
+static void RainClearField( void )
+{
+	memset( rain_field, 0, sizeof( rain_field ));
+	rain_fieldparms = Rain;
+}
+
 /*
 =================================
 ProcessRain
@@ -138,6 +258,11 @@ void ProcessRain( void )
 	int maxDelta; // maximum height randomize distance
 	float falltime;
 
+	// heightfield is traced with the wind and height of the current weather
+	if( rain_fieldparms.windX != Rain.windX || rain_fieldparms.windY != Rain.windY
+	|| rain_fieldparms.globalHeight != Rain.globalHeight || rain_fieldparms.weatherMode != Rain.weatherMode )
+		RainClearField();
+
 	if( Rain.weatherMode == MODE_RAIN )
 	{
 		maxDelta = DRIPSPEED * rain_timedelta; // for rain
@@ -149,6 +274,12 @@ void ProcessRain( void )
 		falltime = (Rain.globalHeight + 4096) / SNOWSPEED;
 	}
 
+	vec3_t vecWind;
+
+	vecWind[0] = falltime * Rain.windX;
+	vecWind[1] = falltime * Rain.windY;
+	vecWind[2] = -4096;
+
 	while( rain_nextspawntime < rain_curtime )
 	{
 		rain_nextspawntime += timeBetweenDrips;		
@@ -162,6 +293,8 @@ void ProcessRain( void )
 			float deathHeight;
 			vec3_t vecStart, vecEnd;
 
+			rain_numspawns++;
+
 			vecStart[0] = RANDOM_FLOAT( RI.vieworg.x - Rain.distFromPlayer, RI.vieworg.x + Rain.distFromPlayer );
 			vecStart[1] = RANDOM_FLOAT( RI.vieworg.y - Rain.distFromPlayer, RI.vieworg.y + Rain.distFromPlayer );
 			vecStart[2] = Rain.globalHeight;
@@ -174,57 +307,35 @@ void ProcessRain( void )
 			vecEnd[1] = falltime * yDelta;
 			vecEnd[2] = -4096;
 
-			pmtrace_t pmtrace;
-			gEngfuncs.pEventAPI->EV_SetTraceHull( 2 );
-			gEngfuncs.pEventAPI->EV_PlayerTrace( vecStart, vecStart + vecEnd, PM_STUDIO_IGNORE, -1, &pmtrace );
+			raincell_t drip, *cell;
+
+			if( cl_rain_heightfield->value )
+			{
+				cell = RainGetCell( vecStart, vecWind );
+			}
+			else
+			{
+				RainTraceDrip( vecStart, vecEnd, &drip );
+				cell = &drip;
+			}
 
-			if( pmtrace.startsolid || pmtrace.allsolid )
+			if( cell->type == RAINCELL_BLOCKED )
 			{
 				if( cl_debug_rain->value )
 					debug_dropped++;
 				continue; // drip cannot be placed
 			}
 
-			// falling to water?
-			int contents = gEngfuncs.PM_PointContents( pmtrace.endpos, NULL );
+			int contents = CONTENTS_EMPTY;
+			deathHeight = cell->height;
 
-			if( contents == CONTENTS_WATER )
+			if( cell->type == RAINCELL_WATER )
 			{
-				int waterEntity = WATER_ENTITY( pmtrace.endpos );
-
-				if( waterEntity > 0 )
-				{
-					cl_entity_t *pwater = gEngfuncs.GetEntityByIndex( waterEntity );
-
-					if( pwater && ( pwater->model != NULL ))
-					{
-						deathHeight = pwater->curstate.maxs.z - 1.0f;
-
-						if( !Mod_BoxVisible( pwater->curstate.mins, pwater->curstate.maxs, Mod_GetCurrentVis( )))
-							contents = CONTENTS_EMPTY; // not error, just water out of PVS
-					}
-					else
-					{
-						ALERT( at_error, "rain: can't get water entity\n" );
-						continue;
-					}
-				}
-				else
-				{
-					ALERT( at_error, "rain: water is not func_water entity\n" );
-					continue;
-				}
-			}
-			else
-			{
-				deathHeight = pmtrace.endpos.z;
-			}
+				cl_entity_t *pwater = gEngfuncs.GetEntityByIndex( cell->waterent );
+				contents = CONTENTS_WATER;
 
-			// just in case..
-			if( deathHeight > vecStart.z )
-			{
-				ALERT( at_error, "rain: can't create drip in water\n");
-				continue;
+				if( !pwater || !Mod_BoxVisible( pwater->curstate.mins, pwater->curstate.maxs, Mod_GetCurrentVis( )))
+					contents = CONTENTS_EMPTY; // not error, just water out of PVS
 			}
 
 
@@ -263,6 +374,14 @@ void ProcessRain( void )
 		}
 	}
 
+	if( rain_curtime >= rain_nextstatstime )
+	{
+		rain_tracespersec = rain_numtraces;
+		rain_spawnspersec = rain_numspawns;
+		rain_numtraces = rain_numspawns = 0;
+		rain_nextstatstime = rain_curtime + 1.0;
+	}
+
 	if( cl_debug_rain->value )
 	{
 		// print debug info
@@ -277,6 +396,9 @@ void ProcessRain( void )
 		}
 		else
 			gEngfuncs.Con_NPrintf( 4, "rain info: Average drip life time: --\n" );
+
+		// without the heightfield every spawn attempt costs a trace
+		gEngfuncs.Con_NPrintf( 5, "rain info: Traces per second: %i, without heightfield: %i\n", rain_tracespersec, rain_spawnspersec );
 	}
 }
 
@@ -692,11 +814,16 @@ InitRain
 void InitRain( void )
 {
 	cl_debug_rain = CVAR_REGISTER( "cl_debug_rain", "0", 0 ); 
+	cl_rain_heightfield = CVAR_REGISTER( "cl_rain_heightfield", "1", 0 );
 	memset( &Rain, 0, sizeof( Rain ));
+	RainClearField();
 
 	rain_oldtime = 0;
 	rain_curtime = 0;
 	rain_nextspawntime = 0;
+	rain_nextstatstime = 0;
+	rain_numtraces = rain_numspawns = 0;
+	rain_tracespersec = rain_spawnspersec = 0;
 }
 
 /*
@@ -26,6 +26,15 @@ GNU General Public License for more details.
 #define MAXDRIPS			20000	//   (   )
 #define MAXFX			10000	//    (    ..)
 
+#define RAINCELL_SIZE			16	// occlusion heightfield texel size in world units
+#define RAINCELL_GRID			256	// texels per side, wrapped around the player (power of two)
+#define RAINCELL_MAXAGE		5.0f	// retrace a texel after this time (doors, trains etc)
+
+#define RAINCELL_EMPTY		0	// not traced yet
+#define RAINCELL_GROUND		1
+#define RAINCELL_WATER		2
+#define RAINCELL_BLOCKED		3	// drip cannot be placed
+
 #define MODE_RAIN			0
 #define MODE_SNOW			1
 
@@ -57,6 +66,16 @@ typedef struct cl_drip
 	int		landInWater;
 } cl_drip_t;
 
+// first hit of the drips that fall through this texel
+typedef struct
+{
+	int		x, y;		// world texel coords (field is wrapped)
+	float		height;		// ground or water surface
+	float		time;		// when it was traced
+	int		waterent;		// func_water entity
+	int		type;
+} raincell_t;
+
 typedef struct cl_rainfx
 {
 	float		birthTime;
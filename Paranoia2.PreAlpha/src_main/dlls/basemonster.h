@@ -73,6 +73,10 @@ public:
 
 		int					m_iHintNode; // this is the hint node that the monster is moving towards or performing active idle on.
 
+		int					m_iNearestNode; // last FindNearestNode result for this monster, seeds the next search
+		int					m_afNearestNodeTypes;
+		int					m_iNearestNodeGraph; // the node graph it belongs to
+
 		int					m_afMemory;
 
 		int					m_iMaxHealth;// keeps track of monster's maximum health value (for re-healing, etc)
@@ -158,6 +158,7 @@ int DispatchSpawn( edict_t *pent )
 		// Initialize these or entities who don't link to the world won't have anything in here
 		pEntity->pev->absmin = pEntity->pev->origin - Vector(1,1,1);
 		pEntity->pev->absmax = pEntity->pev->origin + Vector(1,1,1);
+		UTIL_RelinkEntityGrid( pent );
 
 //		pEntity->InitMoveWith(); //LRC
 		pEntity->Spawn();
@@ -169,6 +170,8 @@ int DispatchSpawn( edict_t *pent )
 
 		if ( pEntity )
 		{
+			UTIL_RelinkEntityNames( pent );
+
 			if ( g_pGameRules && !g_pGameRules->IsAllowedToSpawn( pEntity ) )
 				return -1;	// return that this entity should be deleted
 			if ( pEntity->pev->flags & FL_KILLME )
@@ -399,6 +402,8 @@ int DispatchRestore( edict_t *pent, SAVERESTOREDATA *pSaveData, int globalEntity
 		// Again, could be deleted, get the pointer again.
 		pEntity = (CBaseEntity *)GET_PRIVATE(pent);
 
+		if( pEntity ) UTIL_RelinkEntityNames( pent );
+
 		if( pEntity && pEntity->pev->solid == SOLID_CUSTOM && g_precache_meshes.value )
 		{
 			pEntity->m_BodyMesh.StudioConstructMesh( pEntity );
@@ -457,10 +462,19 @@ void DispatchObjectCollsionBox( edict_t *pent )
 	}
 	else
 		SetObjectCollisionBox( &pent->v );
+
+	UTIL_RelinkEntityGrid( pent );
+	UTIL_RelinkEntityNames( pent );
 }
 
 void OnFreeEntPrivateData( edict_s *pEdict )
 {
+	if( pEdict )
+	{
+		UTIL_UnlinkEntityGrid( pEdict );
+		UTIL_UnlinkEntityNames( pEdict );
+	}
+
 	if( g_fPhysicInitialized )
 	{
 		if( pEdict && pEdict->pvPrivateData )
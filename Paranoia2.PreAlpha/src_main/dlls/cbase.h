@@ -187,6 +187,7 @@ public:
 	Vector				m_vecMoveWithOffset; // LRC- Position I should be in relative to m_pMoveWith->pev->origin.
 	Vector				m_vecRotWithOffset; // LRC- Angles I should be facing relative to m_pMoveWith->pev->angles.
 	CBaseEntity			*m_pAssistLink; // LRC- link to the next entity which needs to be Assisted before physics are applied.
+	CBaseEntity			*m_pAssistPrev; // previous entry in the AssistList, set while the entity is in the list.
 	Vector				m_vecPostAssistVel; // LRC
 	Vector				m_vecPostAssistAVel; // LRC
 	float				m_fNextThink; // LRC - for SetNextThink and SetPhysThink. Marks the time when a think will be performed - not necessarily the same as pev->nextthink!
@@ -198,7 +199,7 @@ public:
 	Vector				m_vecSpawnOffset; // LRC- To fix things which (for example) MoveWith a door which Starts Open.
 	BOOL				m_activated;	// LRC- moved here from func_train. Signifies that an entity has already been
 										// activated. (and hence doesn't need reactivating.)
-	CMeshDesc				m_BodyMesh;	// local copy of body mesh for internal trace (no need to save\restore. it will be rebuild automatically)
+	CBodyMesh				m_BodyMesh;	// shared body mesh for internal trace (no need to save\restore. it will be rebuild automatically)
 
 	//LRC - decent mechanisms for setting think times!
 	// this should have been done a long time ago, but MoveWith finally forced me.
@@ -1032,6 +1033,7 @@ public:
 	void KeyValue( KeyValueData *pkvd );
 
 	CBaseAlias *m_pFirstAlias;
+	CBaseEntity *m_pAssistTail; // last entity in the AssistList
 };
 
 extern CWorld *g_pWorld;
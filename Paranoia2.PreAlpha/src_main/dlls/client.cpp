@@ -779,6 +779,7 @@ void StartFrame( void )
 	gpGlobals->teamplay = teamplay.value;
 	g_ulFrameCount++;
 
+	UTIL_SyncEntityNames();
 //	CheckDesiredList(); //LRC
 	CheckAssistList(); //LRC
 }
@@ -2229,6 +2229,7 @@ void CGibShooter :: ShootThink ( void )
 		if ( pGib )
 		{
 			pGib->pev->targetname = m_iszTargetname;
+			UTIL_RelinkEntityNames( pGib->edict() );
 //			pGib->pev->velocity = vecShootDir * flGibVelocity;
 
 			if (pev->spawnflags & SF_GIBSHOOTER_DEBUG)
@@ -41,6 +41,7 @@ cvar_t	allowmonsters={"mp_allowmonsters","0", FCVAR_SERVER };
 
 cvar_t	impulsetarget={"sohl_impulsetarget","0", FCVAR_SERVER }; //LRC - trigger ents manually
 cvar_t	mw_debug={"sohl_mwdebug","0", FCVAR_SERVER }; //LRC - debug info. for MoveWith. (probably not useful for most people.)
+cvar_t	mw_stats={"sohl_mwstats","0", FCVAR_SERVER }; // MoveWith frame time counters
 
 cvar_t  mp_chattime = {"mp_chattime","10", FCVAR_SERVER };
 
@@ -49,6 +50,10 @@ cvar_t 	*g_psv_gravity = NULL;
 cvar_t	*g_psv_aim = NULL;
 cvar_t	*g_footsteps = NULL;
 cvar_t	g_precache_meshes  = { "sv_precache_meshes","1", FCVAR_ARCHIVE };
+cvar_t	g_verify_nodegraph = { "sv_verify_nodegraph","0" };
+cvar_t	ai_sight_budget = { "ai_sight_budget","0", FCVAR_SERVER };	// max sight traces per frame, 0 is unlimited
+cvar_t	ai_sight_maxage = { "ai_sight_maxage","0.3", FCVAR_SERVER };	// max age of reused sight results, in seconds
+cvar_t	ai_sight_stats = { "ai_sight_stats","0", FCVAR_SERVER };	// sight traces counters
 
 cvar_t	weapon_x =  { "weapon_x", "0", 0 };
 cvar_t	weapon_y =  { "weapon_y", "0", 0 };
@@ -604,6 +609,10 @@ void GameDLLInit( void )
 	g_psv_aim = CVAR_GET_POINTER( "sv_aim" );
 	g_footsteps = CVAR_GET_POINTER( "mp_footsteps" );
 	CVAR_REGISTER( &g_precache_meshes );
+	CVAR_REGISTER( &g_verify_nodegraph );
+	CVAR_REGISTER( &ai_sight_budget );
+	CVAR_REGISTER( &ai_sight_maxage );
+	CVAR_REGISTER( &ai_sight_stats );
 
 	CVAR_REGISTER (&displaysoundlist);
 
@@ -631,6 +640,7 @@ void GameDLLInit( void )
 	CVAR_REGISTER (&allowmonsters);
 	CVAR_REGISTER (&impulsetarget); //LRC
 	CVAR_REGISTER (&mw_debug); //LRC
+	CVAR_REGISTER (&mw_stats);
 
 	CVAR_REGISTER (&mp_chattime);
 
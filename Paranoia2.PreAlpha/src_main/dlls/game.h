@@ -36,12 +36,17 @@ extern cvar_t	teamlist;
 extern cvar_t	teamoverride;
 extern cvar_t	defaultteam;
 extern cvar_t	allowmonsters;
+extern cvar_t	mw_stats;
 
 // Engine Cvars
 extern cvar_t	*g_psv_gravity;
 extern cvar_t	*g_psv_aim;
 extern cvar_t	*g_footsteps;
 extern cvar_t	g_precache_meshes;
+extern cvar_t	g_verify_nodegraph;
+extern cvar_t	ai_sight_budget;
+extern cvar_t	ai_sight_maxage;
+extern cvar_t	ai_sight_stats;
 
 extern cvar_t	weapon_x;
 extern cvar_t	weapon_y;
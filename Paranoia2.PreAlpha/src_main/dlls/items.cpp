@@ -80,6 +80,7 @@ void CWorldItem::Spawn( void )
 	{
 		pEntity->pev->target = pev->target;
 		pEntity->pev->targetname = pev->targetname;
+		UTIL_RelinkEntityNames( pEntity->edict() );
 		pEntity->pev->spawnflags = pev->spawnflags;
 	}
 
@@ -313,6 +313,7 @@ void CLocusBeam::Use( CBaseEntity *pActivator, CBaseEntity *pCaller, USE_TYPE us
 		pBeam->SetNextThink( m_fDuration );
 	}
 	pBeam->pev->targetname = m_iszTargetName;
+	UTIL_RelinkEntityNames( pBeam->edict() );
 
 	if (pev->target)
 	{
@@ -765,6 +766,7 @@ void CLocusVariable::Use( CBaseEntity *pActivator, CBaseEntity *pCaller, USE_TYP
 		pMark->pev->movedir = vecDir;
 		pMark->pev->frags = fRatio;
 		pMark->pev->targetname = m_iszTargetName;
+		UTIL_RelinkEntityNames( pMark->edict() );
 		pMark->SetNextThink(m_fDuration);
 
 		FireTargets(STRING(m_iszFireOnSpawn), pMark, this, USE_TOGGLE, 0);
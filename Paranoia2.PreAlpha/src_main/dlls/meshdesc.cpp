@@ -19,16 +19,30 @@ GNU General Public License for more details.
 #include	"com_model.h"
 #include  "meshdesc.h"
 #include  "trace.h"
+#include  "stringlib.h"
+
+#ifdef __linux__
+#include <sys/stat.h>
+#define CreateDirectory(p, n) mkdir(p, 0777)
+#endif
+
+// all the meshes currently in use
+static CMeshDesc *g_pSharedMeshes = NULL;
 
 CMeshDesc :: CMeshDesc( void )
 {
-	m_origin = m_angles = g_vecZero;
 	memset( &m_mesh, 0, sizeof( m_mesh ));
 
 	m_debugName = NULL;
+	m_szModel[0] = '\0';
+	m_iBody = 0;
+	m_iRefCount = 0;
+	m_pNext = NULL;
 	planehash = NULL;
 	planepool = NULL;
 	facets = NULL;
+	facetorder = NULL;
+	bvhnodes = NULL;
 	m_iNumTris = 0;
 }
 
@@ -37,68 +51,158 @@ CMeshDesc :: ~CMeshDesc( void )
 	FreeMesh ();
 }
 
-void CMeshDesc :: InsertLinkBefore( link_t *l, link_t *before )
+static float BoundsSurfaceArea( const Vector &mins, const Vector &maxs )
 {
-	l->next = before;
-	l->prev = before->prev;
-	l->prev->next = l;
-	l->next->prev = l;
-}
+	Vector size = maxs - mins;
 
-void CMeshDesc :: RemoveLink( link_t *l )
-{
-	l->next->prev = l->prev;
-	l->prev->next = l->next;
-}
-
-void CMeshDesc :: ClearLink( link_t *l )
-{
-	l->prev = l->next = l;
+	return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
 }
 
 /*
 ===============
-CreateAreaNode
+BuildBVHNode
 
-builds a uniformly subdivided tree for the given mesh size
+splits the facets by binned surface area heuristic,
+children of each node are allocated in pairs
 ===============
 */
-areanode_t *CMeshDesc :: CreateAreaNode( int depth, const Vector &mins, const Vector &maxs )
+void CMeshDesc :: BuildBVHNode( int nodenum, int first, int count, int depth )
 {
-	areanode_t	*anode;
-	Vector		size;
-	Vector		mins1, maxs1;
-	Vector		mins2, maxs2;
-
-	anode = &areanodes[numareanodes++];
-
-	// use 'solid_edicts' to store facets
-	ClearLink( &anode->solid_edicts );
-	
-	if( depth == AREA_DEPTH )
-	{
-		anode->axis = -1;
-		anode->children[0] = anode->children[1] = NULL;
-		return anode;
-	}
-	
-	size = maxs - mins;
-
-	if( size[0] > size[1] )
-		anode->axis = 0;
-	else anode->axis = 1;
-	
-	anode->dist = 0.5f * ( maxs[anode->axis] + mins[anode->axis] );
-	mins1 = mins;	
-	mins2 = mins;	
-	maxs1 = maxs;	
-	maxs2 = maxs;	
-	
-	maxs1[anode->axis] = mins2[anode->axis] = anode->dist;
-	anode->children[0] = CreateAreaNode( depth+1, mins2, maxs2 );
-	anode->children[1] = CreateAreaNode( depth+1, mins1, maxs1 );
-
-	return anode;
+	mbvhnode_t	*node = &bvhnodes[nodenum];
+	Vector		cmins, cmaxs, center;
+	Vector		binmins[BVH_BINS], binmaxs[BVH_BINS];
+	Vector		leftmins, leftmaxs;
+	Vector		rightmins, rightmaxs;
+	float		rightarea[BVH_BINS];
+	int		bincount[BVH_BINS];
+	int		rightcount[BVH_BINS];
+	int		i, j, axis, bin;
+	int		leftcount, bestbin;
+	float		extent, cost, bestcost;
+
+	ClearBounds( node->mins, node->maxs );
+	ClearBounds( cmins, cmaxs );
+
+	for( i = first; i < first + count; i++ )
+	{
+		mbuildfacet_t *facet = &facets[facetorder[i]];
+
+		AddPointToBounds( facet->mins, node->mins, node->maxs );
+		AddPointToBounds( facet->maxs, node->mins, node->maxs );
+		center = ( facet->mins + facet->maxs ) * 0.5f;
+		AddPointToBounds( center, cmins, cmaxs );
+	}
+
+	node->firstfacet = first;
+	node->numfacets = count;
+
+	if( count <= BVH_LEAF_FACETS || depth >= BVH_MAX_DEPTH - 1 )
+		return;
+
+	// split along the longest axis of facet centers
+	axis = 0;
+	if( cmaxs[1] - cmins[1] > cmaxs[axis] - cmins[axis] ) axis = 1;
+	if( cmaxs[2] - cmins[2] > cmaxs[axis] - cmins[axis] ) axis = 2;
+	extent = cmaxs[axis] - cmins[axis];
+
+	if( extent <= 0.0f )
+		return; // all the centers are equal, can't split
+
+	for( i = 0; i < BVH_BINS; i++ )
+	{
+		ClearBounds( binmins[i], binmaxs[i] );
+		bincount[i] = 0;
+	}
+
+	for( i = first; i < first + count; i++ )
+	{
+		mbuildfacet_t *facet = &facets[facetorder[i]];
+
+		center = ( facet->mins + facet->maxs ) * 0.5f;
+		bin = (int)( BVH_BINS * ( center[axis] - cmins[axis] ) / extent );
+		bin = bound( 0, bin, BVH_BINS - 1 );
+		AddPointToBounds( facet->mins, binmins[bin], binmaxs[bin] );
+		AddPointToBounds( facet->maxs, binmins[bin], binmaxs[bin] );
+		bincount[bin]++;
+	}
+
+	// sweep from the right to get areas of the right side for each split
+	ClearBounds( rightmins, rightmaxs );
+	for( i = BVH_BINS - 1, j = 0; i > 0; i-- )
+	{
+		if( bincount[i] )
+		{
+			AddPointToBounds( binmins[i], rightmins, rightmaxs );
+			AddPointToBounds( binmaxs[i], rightmins, rightmaxs );
+		}
+		j += bincount[i];
+		rightcount[i] = j;
+		rightarea[i] = j ? BoundsSurfaceArea( rightmins, rightmaxs ) : 0.0f;
+	}
+
+	// and from the left to find the cheapest one (split is after 'bestbin')
+	ClearBounds( leftmins, leftmaxs );
+	bestbin = -1;
+	bestcost = 0.0f;
+	leftcount = 0;
+
+	for( i = 0; i < BVH_BINS - 1; i++ )
+	{
+		if( bincount[i] )
+		{
+			AddPointToBounds( binmins[i], leftmins, leftmaxs );
+			AddPointToBounds( binmaxs[i], leftmins, leftmaxs );
+		}
+		leftcount += bincount[i];
+
+		if( !leftcount || !rightcount[i+1] )
+			continue;
+
+		cost = BoundsSurfaceArea( leftmins, leftmaxs ) * leftcount + rightarea[i+1] * rightcount[i+1];
+
+		if( bestbin == -1 || cost < bestcost )
+		{
+			bestcost = cost;
+			bestbin = i;
+		}
+	}
+
+	if( bestbin == -1 )
+		return;
+
+	// keep the small leafs when the split is more expensive than testing all the facets
+	if( count <= BVH_MAX_LEAF_FACETS && 1.0f + bestcost / BoundsSurfaceArea( node->mins, node->maxs ) >= count )
+		return;
+
+	// partition the facets
+	for( i = first, j = first + count - 1; i <= j; )
+	{
+		mbuildfacet_t *facet = &facets[facetorder[i]];
+
+		center = ( facet->mins + facet->maxs ) * 0.5f;
+		bin = (int)( BVH_BINS * ( center[axis] - cmins[axis] ) / extent );
+		bin = bound( 0, bin, BVH_BINS - 1 );
+
+		if( bin <= bestbin )
+		{
+			i++;
+		}
+		else
+		{
+			int tmp = facetorder[i];
+			facetorder[i] = facetorder[j];
+			facetorder[j--] = tmp;
+		}
+	}
+
+	leftcount = i - first;
+
+	node->firstfacet = numbvhnodes;
+	node->numfacets = 0;
+	numbvhnodes += 2;
+
+	BuildBVHNode( node->firstfacet + 0, first, leftcount, depth + 1 );
+	BuildBVHNode( node->firstfacet + 1, first + leftcount, count - leftcount, depth + 1 );
 }
 
 void CMeshDesc :: FreeMesh( void )
@@ -123,21 +227,14 @@ bool CMeshDesc :: InitMeshBuild( const char *debug_name, int numTriangles )
 	if( numTriangles >= 5000 )
 		ALERT( at_warning, "%s have too many triangles (%i)\n", debug_name, numTriangles );
 
-	if( numTriangles >= 256 )
-		has_tree = true;	// too many triangles invoke to build AABB tree
-	else has_tree = false;
-
 	ClearBounds( m_mesh.mins, m_mesh.maxs );
 
-	memset( areanodes, 0, sizeof( areanodes ));
-	numareanodes = 0;
-
 	m_debugName = debug_name;
 	m_iNumTris = numTriangles;
 	m_iTotalPlanes = 0;
 
 	// create pools for construct mesh
-	facets = (mfacet_t *)calloc( sizeof( mfacet_t ), numTriangles );
+	facets = (mbuildfacet_t *)calloc( sizeof( mbuildfacet_t ), numTriangles );
 	planehash = (hashplane_t **)calloc( sizeof( hashplane_t* ), PLANE_HASHES );
 	planepool = (hashplane_t *)calloc( sizeof( hashplane_t ), MAX_PLANES );
 
@@ -237,6 +334,31 @@ bool CMeshDesc :: StudioConstructMesh( CBaseEntity *pEnt )
 
 	float start_time = g_engfuncs.pfnTime();
 
+	strncpy( m_szModel, STRING( pEnt->pev->model ), sizeof( m_szModel ) - 1 );
+	m_szModel[sizeof( m_szModel ) - 1] = '\0';
+	m_iBody = pEnt->pev->body;
+
+	// cached mesh is valid only for exactly the same model. Check the file on disk,
+	// the model in memory is shared with the client which writes texture ids into it
+	CRC32_t modelcrc;
+	int modellength;
+	byte *aModelFile = LOAD_FILE_FOR_ME( m_szModel, &modellength );
+	bool usecache = ( aModelFile != NULL );
+
+	CRC32_INIT( &modelcrc );
+	if( aModelFile )
+	{
+		CRC32_PROCESS_BUFFER( &modelcrc, aModelFile, modellength );
+		FREE_FILE( aModelFile );
+	}
+	modelcrc = CRC32_FINAL( modelcrc );
+
+	if( usecache && LoadMeshCache( modelcrc ))
+	{
+		ALERT( at_aiconsole, "%s: loaded from cache, size %i k\n", m_debugName, ( mesh_size / 1024 ));
+		return true;
+	}
+
 	// compute default pose for building mesh from
 	mstudioseqdesc_t *pseqdesc = (mstudioseqdesc_t *)((byte *)phdr + phdr->seqindex);
 	mstudioseqgroup_t *pseqgroup = (mstudioseqgroup_t *)((byte *)phdr + phdr->seqgroupindex) + pseqdesc->seqgroup;
@@ -261,17 +383,16 @@ bool CMeshDesc :: StudioConstructMesh( CBaseEntity *pEnt )
 	}
 
 	pbone = (mstudiobone_t *)((byte *)phdr + phdr->boneindex);
-	matrix3x4	transform, bonematrix, bonetransform[MAXSTUDIOBONES];
-	transform = matrix3x4( pEnt->pev->origin, pEnt->pev->angles );
+	matrix3x4	bonematrix, bonetransform[MAXSTUDIOBONES];
 
-	// compute bones for default anim
+	// compute bones for default anim (in model space)
 	for( i = 0; i < phdr->numbones; i++ ) 
 	{
 		// initialize bonematrix
 		bonematrix = matrix3x4( pos[i], q[i] );
 
 		if( pbone[i].parent == -1 ) 
-			bonetransform[i] = transform.ConcatTransforms( bonematrix );
+			bonetransform[i] = bonematrix;
 		else bonetransform[i] = bonetransform[pbone[i].parent].ConcatTransforms( bonematrix );
 	}
 
@@ -382,7 +503,7 @@ bool CMeshDesc :: StudioConstructMesh( CBaseEntity *pEnt )
 	if( numTris != ( numElems / 3 ))
 		ALERT( at_error, "StudioConstructMesh: mismatch triangle count (%i should be %i)\n", (numElems / 3), numTris );
 
-	InitMeshBuild( STRING( pEnt->pev->model ), numTris );
+	InitMeshBuild( m_szModel, numTris );
 
 	for( i = 0; i < numElems; i += 3 )
 	{
@@ -404,9 +525,9 @@ bool CMeshDesc :: StudioConstructMesh( CBaseEntity *pEnt )
 		return false;
 	}
 
-	// position are changed. Cache new values and rebuild mesh
-	m_origin = pEnt->pev->origin;
-	m_angles = pEnt->pev->angles;
+	if( usecache )
+		SaveMeshCache( modelcrc );
+
 #if 1
 	// g-cont. i'm leave this for debug
 	ALERT( at_aiconsole, "%s: build time %g secs, size %i k\n", m_debugName, g_engfuncs.pfnTime() - start_time, ( mesh_size / 1024 ));
@@ -432,7 +553,7 @@ bool CMeshDesc :: AddMeshTrinagle( const Vector triangle[3] )
 	for( i = 0; i < 3; i++ )
 		AddPointToBounds( triangle[i], m_mesh.mins, m_mesh.maxs );
 
-	mfacet_t *facet = &facets[m_mesh.numfacets];
+	mbuildfacet_t *facet = &facets[m_mesh.numfacets];
 	mplane_t mainplane;
 
 	// calculate plane for this triangle
@@ -579,25 +700,6 @@ bool CMeshDesc :: AddMeshTrinagle( const Vector triangle[3] )
 	return true;
 }
 
-void CMeshDesc :: RelinkFacet( mfacet_t *facet )
-{
-	// find the first node that the facet box crosses
-	areanode_t *node = areanodes;
-
-	while( 1 )
-	{
-		if( node->axis == -1 ) break;
-		if( facet->mins[node->axis] > node->dist )
-			node = node->children[0];
-		else if( facet->maxs[node->axis] < node->dist )
-			node = node->children[1];
-		else break; // crosses the node
-	}
-	
-	// link it in	
-	InsertLinkBefore( &facet->area, &node->solid_edicts );
-}
-
 bool CMeshDesc :: FinishMeshBuild( void )
 {
 	if( m_mesh.numfacets <= 0 )
@@ -614,7 +716,20 @@ bool CMeshDesc :: FinishMeshBuild( void )
 		m_mesh.maxs[i] += 1.0f;
 	}
 
-	size_t memsize = (sizeof( mfacet_t ) * m_mesh.numfacets) + (sizeof( mplane_t ) * m_mesh.numplanes) + (sizeof( word ) * m_iTotalPlanes);
+	// build the tree, it also sorts facets by leafs
+	facetorder = (int *)malloc( sizeof( int ) * m_mesh.numfacets );
+	bvhnodes = (mbvhnode_t *)malloc( sizeof( mbvhnode_t ) * m_mesh.numfacets * 2 );
+	numbvhnodes = 1;
+
+	for( i = 0; i < m_mesh.numfacets; i++ )
+		facetorder[i] = i;
+
+	BuildBVHNode( 0, 0, m_mesh.numfacets, 0 );
+
+	m_mesh.numfacetplanes = m_iTotalPlanes;
+	m_mesh.numnodes = numbvhnodes;
+
+	size_t memsize = (sizeof( mplane_t ) * m_mesh.numfacetplanes) + (sizeof( mfacet_t ) * m_mesh.numfacets) + (sizeof( mbvhnode_t ) * m_mesh.numnodes);
 
 	// create non-fragmented memory piece and move mesh
 	byte *buffer = (byte *)malloc( memsize );
@@ -622,45 +737,34 @@ bool CMeshDesc :: FinishMeshBuild( void )
 
 	// setup pointers
 	m_mesh.planes = (mplane_t *)buffer; // so we free mem with planes
-	buffer += (sizeof( mplane_t ) * m_mesh.numplanes);
+	buffer += (sizeof( mplane_t ) * m_mesh.numfacetplanes);
 	m_mesh.facets = (mfacet_t *)buffer;
 	buffer += (sizeof( mfacet_t ) * m_mesh.numfacets);
-
-	// setup mesh pointers
-	for( i = 0; i < m_mesh.numfacets; i++ )
-	{
-		m_mesh.facets[i].indices = (word *)buffer;
-		buffer += (sizeof( word ) * facets[i].numplanes);
-	}
+	m_mesh.nodes = (mbvhnode_t *)buffer;
+	buffer += (sizeof( mbvhnode_t ) * m_mesh.numnodes);
 
 	if( buffer != bufend )
 		ALERT( at_error, "FinishMeshBuild: memory representation error! %x != %x\n", buffer, bufend );
 
-	// copy planes into mesh array (probably aligned block)
-	for( i = 0; i < m_mesh.numplanes; i++ )
-		m_mesh.planes[i] = planepool[i].pl;
+	// copy facets in order of the tree leafs, each followed by its own planes
+	mplane_t *plane = m_mesh.planes;
 
-	// copy planes into mesh array (probably aligned block)
 	for( i = 0; i < m_mesh.numfacets; i++ )
 	{
-		m_mesh.facets[i].mins = facets[i].mins;
-		m_mesh.facets[i].maxs = facets[i].maxs;
-		m_mesh.facets[i].area.next = m_mesh.facets[i].area.prev = NULL;
-		m_mesh.facets[i].numplanes = facets[i].numplanes;
+		mbuildfacet_t *in = &facets[facetorder[i]];
+		mfacet_t *out = &m_mesh.facets[i];
 
-		for( int j = 0; j < facets[i].numplanes; j++ )
-			m_mesh.facets[i].indices[j] = facets[i].indices[j];
-	}
+		out->mins = in->mins;
+		out->maxs = in->maxs;
+		out->numplanes = in->numplanes;
+		out->planes = plane;
 
-	if( has_tree )
-	{
-		// create tree
-		CreateAreaNode( 0, m_mesh.mins, m_mesh.maxs );
-
-		for( int i = 0; i < m_mesh.numfacets; i++ )
-			RelinkFacet( &m_mesh.facets[i] );
+		for( int j = 0; j < in->numplanes; j++ )
+			*plane++ = planepool[in->indices[j]].pl;
 	}
 
+	memcpy( m_mesh.nodes, bvhnodes, sizeof( mbvhnode_t ) * m_mesh.numnodes );
+
 	FreeMeshBuild();
 
 	mesh_size = sizeof( m_mesh ) + memsize;
@@ -681,23 +785,306 @@ void CMeshDesc :: FreeMeshBuild( void )
 	free( planehash );
 	free( planepool );
 	free( facets );
+	free( facetorder );
+	free( bvhnodes );
 
 	planehash = NULL;
 	planepool = NULL;
 	facets = NULL;
+	facetorder = NULL;
+	bvhnodes = NULL;
 }
 
-mmesh_t *CMeshDesc :: CheckMesh( const Vector &origin, const Vector &angles )
+void CMeshDesc :: MeshCacheFileName( char *name, int size )
 {
-	if( origin == m_origin && angles == m_angles )
-		return &m_mesh;
+	char	base[64];
+	const char *in = m_szModel;
+	char	*out = base;
+
+	// flatten the model path: "models/props/chair.mdl" becomes "props_chair"
+	if( !strnicmp( in, "models/", 7 ))
+		in += 7;
+
+	while( *in && *in != '.' && out < base + sizeof( base ) - 1 )
+	{
+		if( *in == '/' || *in == '\\' )
+			*out++ = '_';
+		else *out++ = *in;
+		in++;
+	}
+	*out = '\0';
+
+	Q_snprintf( name, size, "models/meshcache/%s_%i.msh", base, m_iBody );
+}
+
+/*
+================
+CheckMeshNodes
+
+make sure the tree from cache file can't
+send the trace out of the mesh arrays
+================
+*/
+bool CMeshDesc :: CheckMeshNodes( void )
+{
+	int	*depth = (int *)calloc( m_mesh.numnodes, sizeof( int ));
+	bool	valid = true;
+
+	for( int i = 0; i < m_mesh.numnodes && valid; i++ )
+	{
+		mbvhnode_t *node = &m_mesh.nodes[i];
+
+		if( node->numfacets < 0 || node->firstfacet < 0 )
+		{
+			valid = false;
+		}
+		else if( node->numfacets )
+		{
+			// leaf
+			if( node->firstfacet + node->numfacets > m_mesh.numfacets )
+				valid = false;
+		}
+		else
+		{
+			// children are always allocated in pairs after the parent
+			if( node->firstfacet <= i || node->firstfacet + 1 >= m_mesh.numnodes || depth[i] >= BVH_MAX_DEPTH - 1 )
+				valid = false;
+			else depth[node->firstfacet] = depth[node->firstfacet + 1] = depth[i] + 1;
+		}
+	}
+
+	free( depth );
+
+	return valid;
+}
+
+bool CMeshDesc :: LoadMeshCache( CRC32_t modelcrc )
+{
+	char		filename[MAX_PATH];
+	dmeshcache_t	*hdr;
+	dmeshfacet_t	*infacet;
+	byte		*aMemFile;
+	int		i, length;
+
+	MeshCacheFileName( filename, sizeof( filename ));
+	aMemFile = LOAD_FILE_FOR_ME( filename, &length );
+
+	if( !aMemFile )
+		return false;
+
+	hdr = (dmeshcache_t *)aMemFile;
+
+	if( length < (int)sizeof( dmeshcache_t ) || hdr->ident != MESHCACHE_IDENT || hdr->version != MESHCACHE_VERSION )
+	{
+		ALERT( at_aiconsole, "%s has wrong version, rebuild\n", filename );
+		FREE_FILE( aMemFile );
+		return false;
+	}
+
+	if( hdr->modelcrc != modelcrc || hdr->body != m_iBody )
+	{
+		// model was changed since cache was written
+		FREE_FILE( aMemFile );
+		return false;
+	}
+
+	size_t memsize = (sizeof( mplane_t ) * hdr->numfacetplanes) + (sizeof( mfacet_t ) * hdr->numfacets) + (sizeof( mbvhnode_t ) * hdr->numnodes);
+	size_t filesize = sizeof( dmeshcache_t ) + (sizeof( mplane_t ) * hdr->numfacetplanes) + (sizeof( dmeshfacet_t ) * hdr->numfacets) + (sizeof( mbvhnode_t ) * hdr->numnodes);
+
+	if( hdr->numfacets <= 0 || hdr->numfacets > 0xFFFF || hdr->numnodes <= 0 || hdr->numfacetplanes < 0 || length != (int)filesize )
+	{
+		ALERT( at_aiconsole, "%s is corrupted, rebuild\n", filename );
+		FREE_FILE( aMemFile );
+		return false;
+	}
+
+	FreeMesh();
+
+	// same non-fragmented memory piece as FinishMeshBuild makes
+	byte *buffer = (byte *)malloc( memsize );
+	byte *pMemFile = aMemFile + sizeof( dmeshcache_t );
+
+	m_mesh.planes = (mplane_t *)buffer;
+	buffer += (sizeof( mplane_t ) * hdr->numfacetplanes);
+	m_mesh.facets = (mfacet_t *)buffer;
+	buffer += (sizeof( mfacet_t ) * hdr->numfacets);
+	m_mesh.nodes = (mbvhnode_t *)buffer;
+
+	m_mesh.mins = hdr->mins;
+	m_mesh.maxs = hdr->maxs;
+	m_mesh.numfacets = hdr->numfacets;
+	m_mesh.numplanes = hdr->numplanes;
+	m_mesh.numfacetplanes = hdr->numfacetplanes;
+	m_mesh.numnodes = hdr->numnodes;
+
+	memcpy( m_mesh.planes, pMemFile, sizeof( mplane_t ) * m_mesh.numfacetplanes );
+	pMemFile += sizeof( mplane_t ) * m_mesh.numfacetplanes;
+
+	// restore the facet plane pointers
+	mplane_t *plane = m_mesh.planes;
+	int numfacetplanes = 0;
+	infacet = (dmeshfacet_t *)pMemFile;
+
+	for( i = 0; i < m_mesh.numfacets; i++, infacet++ )
+	{
+		if( infacet->numplanes < 0 || numfacetplanes + infacet->numplanes > m_mesh.numfacetplanes )
+		{
+			ALERT( at_aiconsole, "%s is corrupted, rebuild\n", filename );
+			FREE_FILE( aMemFile );
+			FreeMesh();
+			return false;
+		}
+
+		numfacetplanes += infacet->numplanes;
+		m_mesh.facets[i].mins = infacet->mins;
+		m_mesh.facets[i].maxs = infacet->maxs;
+		m_mesh.facets[i].numplanes = infacet->numplanes;
+		m_mesh.facets[i].planes = plane;
+		plane += infacet->numplanes;
+	}
+	pMemFile = (byte *)infacet;
+
+	memcpy( m_mesh.nodes, pMemFile, sizeof( mbvhnode_t ) * m_mesh.numnodes );
+	FREE_FILE( aMemFile );
+
+	if( plane != m_mesh.planes + m_mesh.numfacetplanes || !CheckMeshNodes( ))
+	{
+		ALERT( at_aiconsole, "%s is corrupted, rebuild\n", filename );
+		FreeMesh();
+		return false;
+	}
+
+	m_debugName = m_szModel;
+	mesh_size = sizeof( m_mesh ) + memsize;
+
+	return true;
+}
+
+void CMeshDesc :: SaveMeshCache( CRC32_t modelcrc )
+{
+	char		filename[MAX_PATH];
+	char		relname[MAX_PATH];
+	dmeshcache_t	hdr;
+	dmeshfacet_t	outfacet;
+	FILE		*file;
+
+	// make sure directories have been made
+	GET_GAME_DIR( filename );
+	strcat( filename, "/models" );
+	CreateDirectory( filename, NULL );
+	strcat( filename, "/meshcache" );
+	CreateDirectory( filename, NULL );
+
+	GET_GAME_DIR( filename );
+	MeshCacheFileName( relname, sizeof( relname ));
+	strcat( filename, "/" );
+	strcat( filename, relname );
+
+	file = fopen( filename, "wb" );
+
+	if( !file )
+	{
+		// couldn't create
+		ALERT( at_aiconsole, "Couldn't Create: %s\n", filename );
+		return;
+	}
+
+	memset( &hdr, 0, sizeof( hdr ));
+	hdr.ident = MESHCACHE_IDENT;
+	hdr.version = MESHCACHE_VERSION;
+	hdr.modelcrc = modelcrc;
+	hdr.body = m_iBody;
+	hdr.mins = m_mesh.mins;
+	hdr.maxs = m_mesh.maxs;
+	hdr.numfacets = m_mesh.numfacets;
+	hdr.numplanes = m_mesh.numplanes;
+	hdr.numfacetplanes = m_mesh.numfacetplanes;
+	hdr.numnodes = m_mesh.numnodes;
+
+	fwrite( &hdr, sizeof( hdr ), 1, file );
+	fwrite( m_mesh.planes, sizeof( mplane_t ), m_mesh.numfacetplanes, file );
+
+	for( int i = 0; i < m_mesh.numfacets; i++ )
+	{
+		outfacet.mins = m_mesh.facets[i].mins;
+		outfacet.maxs = m_mesh.facets[i].maxs;
+		outfacet.numplanes = m_mesh.facets[i].numplanes;
+		fwrite( &outfacet, sizeof( outfacet ), 1, file );
+	}
+
+	fwrite( m_mesh.nodes, sizeof( mbvhnode_t ), m_mesh.numnodes, file );
+	fclose( file );
+}
+
+bool CBodyMesh :: StudioConstructMesh( CBaseEntity *pEnt )
+{
+	const char *model = STRING( pEnt->pev->model );
+	CMeshDesc *pDesc;
+
+	FreeMesh();
+
+	// identical props share the single copy
+	for( pDesc = g_pSharedMeshes; pDesc; pDesc = pDesc->m_pNext )
+	{
+		if( pDesc->m_iBody == pEnt->pev->body && !stricmp( pDesc->m_szModel, model ))
+			break;
+	}
+
+	if( !pDesc )
+	{
+		pDesc = new CMeshDesc;
+
+		if( !pDesc->StudioConstructMesh( pEnt ))
+		{
+			delete pDesc;
+			return false;
+		}
+
+		pDesc->m_pNext = g_pSharedMeshes;
+		g_pSharedMeshes = pDesc;
+	}
+
+	pDesc->m_iRefCount++;
+	m_pMeshDesc = pDesc;
+	m_iModelIndex = pEnt->pev->modelindex;
+	m_iBody = pEnt->pev->body;
+
+	return true;
+}
+
+void CBodyMesh :: FreeMesh( void )
+{
+	CMeshDesc **prev;
+
+	if( !m_pMeshDesc )
+		return;
+
+	if( --m_pMeshDesc->m_iRefCount <= 0 )
+	{
+		// last user is gone, unlink and release
+		for( prev = &g_pSharedMeshes; *prev; prev = &(*prev)->m_pNext )
+		{
+			if( *prev == m_pMeshDesc )
+			{
+				*prev = m_pMeshDesc->m_pNext;
+				break;
+			}
+		}
+
+		delete m_pMeshDesc;
+	}
+
+	m_pMeshDesc = NULL;
+}
+
+CMeshDesc *CBodyMesh :: CheckMesh( CBaseEntity *pEnt )
+{
+	// mesh is in model space so only model or body changes requires a different mesh
+	if( m_pMeshDesc && m_iModelIndex == pEnt->pev->modelindex && m_iBody == pEnt->pev->body )
+		return m_pMeshDesc;
 
 	// release old copy
 	FreeMesh ();
 
-	// position are changed. Cache new values and rebuild mesh
-	m_origin = origin;
-	m_angles = angles;
-
 	return NULL;
-}
\ No newline at end of file
+}
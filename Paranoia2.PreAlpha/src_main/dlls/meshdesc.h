@@ -18,8 +18,10 @@ GNU General Public License for more details.
 
 #include "studio.h"
 
-#define AREA_NODES			32
-#define AREA_DEPTH			4
+#define BVH_MAX_DEPTH		64		// also a trace stack size
+#define BVH_LEAF_FACETS		4		// never split a smaller leaf
+#define BVH_MAX_LEAF_FACETS		16		// split a bigger leaf even if SAH doesn't like it
+#define BVH_BINS			16		// SAH buckets per split
 
 #define MAX_FACET_PLANES		32
 #define MAX_PLANES			65536		// unsigned short limit
@@ -31,40 +33,86 @@ typedef struct hashplane_s
 	struct hashplane_s	*hash;
 } hashplane_t;
 
+// facet while mesh is constructed
 typedef struct
 {
-	link_t	area;				// linked to a division node or leaf
 	Vector	mins, maxs;			// an individual size of each facet
 	byte	numplanes;			// because numplanes for each facet can't exceeds MAX_FACET_PLANES!
 	word	*indices;				// a indexes into mesh plane pool
+} mbuildfacet_t;
+
+typedef struct
+{
+	Vector	mins, maxs;			// an individual size of each facet
+	int	numplanes;
+	mplane_t	*planes;				// facet planes are stored contiguously in facet order
 } mfacet_t;
 
+typedef struct
+{
+	Vector	mins, maxs;
+	int	firstfacet;			// leaf: first facet, node: first of the two children
+	int	numfacets;			// 0 for nodes
+} mbvhnode_t;
+
 typedef struct
 {
 	Vector	mins, maxs;
 	word	numfacets;
-	word	numplanes;
-	mfacet_t	*facets;
-	mplane_t	*planes;				// shared plane pool
+	word	numplanes;			// unique planes
+	int	numfacetplanes;
+	int	numnodes;
+	mfacet_t	*facets;				// in order of the tree leafs
+	mplane_t	*planes;				// all the facet planes
+	mbvhnode_t	*nodes;				// surface area heuristic BVH, root is the first node
 } mmesh_t;
 
+// collision mesh cache file (models/meshcache/*.msh)
+#define MESHCACHE_IDENT		(('H'<<24)+('S'<<16)+('E'<<8)+'M') // little-endian "MESH"
+#define MESHCACHE_VERSION		1
+
+typedef struct
+{
+	int	ident;
+	int	version;
+	CRC32_t	modelcrc;				// cache is invalid when model was changed
+	int	body;
+	Vector	mins, maxs;
+	int	numfacets;
+	int	numplanes;			// unique planes, just for stats
+	int	numfacetplanes;
+	int	numnodes;
+} dmeshcache_t;
+
+// followed by numfacetplanes mplane_t, numfacets dmeshfacet_t and numnodes mbvhnode_t
+typedef struct
+{
+	Vector	mins, maxs;
+	int	numplanes;
+} dmeshfacet_t;
+
+// mesh is built in model space and shared between all the entities with the same model and body
 class CMeshDesc
 {
+	friend class CBodyMesh;
 private:
 	mmesh_t		m_mesh;
 	const char	*m_debugName;		// just for debug purpoces
-	Vector		m_origin, m_angles;		// cached values to compare with
-	areanode_t	areanodes[AREA_NODES];	// AABB tree for speedup trace test
-	int		numareanodes;
-	bool		has_tree;			// build AABB tree
+	char		m_szModel[64];		// shared mesh key: model name and body
+	int		m_iBody;
+	int		m_iRefCount;		// number of entities who use this mesh
+	CMeshDesc		*m_pNext;			// next mesh in the shared list
 	int		m_iTotalPlanes;		// just for stats
 	int		m_iNumTris;		// if > 0 we are in build mode
 	size_t		mesh_size;		// mesh total size
 
 	// used only while mesh is contsructed
-	mfacet_t		*facets;
+	mbuildfacet_t	*facets;
 	hashplane_t	**planehash;
 	hashplane_t	*planepool;
+	int		*facetorder;		// facets sorted by tree leafs
+	mbvhnode_t	*bvhnodes;
+	int		numbvhnodes;
 public:
 	CMeshDesc();
 	~CMeshDesc();
@@ -81,22 +129,38 @@ public:
 	void StudioCalcBonePosition( mstudiobone_t *pbone, mstudioanim_t *panim, Vector &pos );
 	bool StudioConstructMesh( CBaseEntity *pEnt );
 
-	// linked list operations
-	void InsertLinkBefore( link_t *l, link_t *before );
-	void RemoveLink( link_t *l );
-	void ClearLink( link_t *l );
-
-	// AABB tree contsruction
-	areanode_t *CreateAreaNode( int depth, const Vector &mins, const Vector &maxs );
-	void RelinkFacet( mfacet_t *facet );
-	_inline areanode_t *GetHeadNode( void ) { return (has_tree) ? &areanodes[0] : NULL; }
+	// BVH contsruction
+	void BuildBVHNode( int nodenum, int first, int count, int depth );
 
 	// plane cache
 	word AddPlaneToPool( const mplane_t *pl );
 
-	// check for cache
-	mmesh_t *CheckMesh( const Vector &origin, const Vector &angles );
+	// cache files
+	void MeshCacheFileName( char *name, int size );
+	bool LoadMeshCache( CRC32_t modelcrc );
+	bool CheckMeshNodes( void );
+	void SaveMeshCache( CRC32_t modelcrc );
+
 	_inline mmesh_t *GetMesh() { return &m_mesh; } 
 };
 
+// entity reference to the shared mesh. Entity moves doesn't touch the mesh,
+// traces are transformed into model space instead
+class CBodyMesh
+{
+private:
+	CMeshDesc		*m_pMeshDesc;
+	int		m_iModelIndex;		// cached values to compare with
+	int		m_iBody;
+public:
+	CBodyMesh() { m_pMeshDesc = NULL; }
+	~CBodyMesh() { FreeMesh(); }
+
+	bool StudioConstructMesh( CBaseEntity *pEnt );	// find the shared mesh or build a new one
+	void FreeMesh( void );			// release the reference
+
+	// check for cache
+	CMeshDesc *CheckMesh( CBaseEntity *pEnt );
+};
+
 #endif//MESHDESC_H
\ No newline at end of file
@@ -279,6 +279,7 @@ CBaseMonster* CMonsterMaker::MakeMonster( void )
 	{
 		// if I have a netname (overloaded), give the child monster that name as a targetname
 		pevCreate->targetname = pev->netname;
+		UTIL_RelinkEntityNames( ENT( pevCreate ));
 	}
 
 	m_cLiveChildren++;// count this monster
@@ -34,6 +34,7 @@
 #include "soundent.h"
 #include "gamerules.h"
 #include "player.h" // buz
+#include "game.h"
 
 #define MONSTER_CUT_CORNER_DIST		8 // 8 means the monster's bounding box is contained without the box of the node in WC
 
@@ -43,6 +44,7 @@ Vector VecBModelOrigin( entvars_t* pevBModel );
 extern DLL_GLOBAL	BOOL	g_fDrawLines;
 extern DLL_GLOBAL	short	g_sModelIndexLaser;// holds the index for the laser beam
 extern DLL_GLOBAL	short	g_sModelIndexLaserDot;// holds the index for the laser beam dot
+extern DLL_GLOBAL	ULONG	g_ulFrameCount;
 
 extern char PM_FindTextureType( char *name );
 
@@ -303,6 +305,234 @@ BOOL CBaseMonster :: FValidateHintType ( short sHint )
 	return FALSE;
 }
 
+//=========================================================
+// Sight queries. Look traces from the looker's eyes to every
+// candidate, so in a big fight each pair is traced twice a
+// frame and the trace count grows with the square of the
+// monster count. The results are kept per pair of edicts:
+// a result traced this frame along the same line is shared
+// with the other monster of the pair. With ai_sight_budget
+// set each looker gets an equal share of the frame budget and
+// refreshes its oldest results first, the rest are deferred
+// and reuse the last known result, unless it's older than
+// ai_sight_maxage.
+//=========================================================
+#define SIGHT_HASH_SIZE		4096		// must be a power of two
+#define MAX_SIGHT_QUERIES		100		// size of the Look candidates list
+
+typedef struct
+{
+	edict_t	*pent1, *pent2;			// pent1 < pent2
+	int	serial1, serial2;			// edicts are reused by the other entities
+	Vector	vecStart, vecEnd;			// traced line
+	ULONG	frame;
+	float	time;
+	BOOL	visible;
+} sightpair_t;
+
+static sightpair_t	g_SightPairs[SIGHT_HASH_SIZE];
+static ULONG	g_ulSightFrame;
+static int	g_iSightTraces;			// traces done this frame
+static int	g_iSightLookers;			// lookers this frame
+static int	g_iSightLastLookers = 1;		// lookers last frame, to share the budget
+
+// ai_sight_stats counters, reported once per second
+static int	g_iStatSightFrames;
+static int	g_iStatSightQueries;
+static int	g_iStatSightTraces;
+static int	g_iStatSightShared;
+static int	g_iStatSightDeferred;
+static int	g_iStatSightMaxTraces;
+static float	g_flNextSightReport;
+
+static void SightBeginFrame( void )
+{
+	if ( g_ulSightFrame == g_ulFrameCount )
+		return;
+
+	if ( ai_sight_stats.value )
+	{
+		g_iStatSightFrames++;
+		g_iStatSightTraces += g_iSightTraces;
+		g_iStatSightMaxTraces = max( g_iStatSightMaxTraces, g_iSightTraces );
+
+		if ( gpGlobals->time >= g_flNextSightReport || gpGlobals->time < g_flNextSightReport - 2.0f )
+		{
+			ALERT( at_console, "Sight: %d frames, %.1f queries, %.1f traces (max %d), %.1f shared, %.1f deferred per frame\n",
+				g_iStatSightFrames, (float)g_iStatSightQueries / g_iStatSightFrames, (float)g_iStatSightTraces / g_iStatSightFrames,
+				g_iStatSightMaxTraces, (float)g_iStatSightShared / g_iStatSightFrames, (float)g_iStatSightDeferred / g_iStatSightFrames );
+
+			g_iStatSightFrames = g_iStatSightQueries = g_iStatSightTraces = 0;
+			g_iStatSightShared = g_iStatSightDeferred = g_iStatSightMaxTraces = 0;
+			g_flNextSightReport = gpGlobals->time + 1.0f;
+		}
+	}
+
+	g_iSightLastLookers = max( g_iSightLookers, 1 );
+	g_iSightLookers = g_iSightTraces = 0;
+	g_ulSightFrame = g_ulFrameCount;
+}
+
+static int SightHash( edict_t *pent1, edict_t *pent2 )
+{
+	return ( ENTINDEX( pent1 ) * 1021 + ENTINDEX( pent2 )) & (SIGHT_HASH_SIZE - 1);
+}
+
+// returns NULL if the pair has no result
+static sightpair_t *SightFindPair( edict_t *pent1, edict_t *pent2 )
+{
+	if ( pent1 > pent2 )
+	{
+		edict_t *pTemp = pent1;
+		pent1 = pent2;
+		pent2 = pTemp;
+	}
+
+	sightpair_t *pPair = &g_SightPairs[SightHash( pent1, pent2 )];
+
+	if ( pPair->pent1 != pent1 || pPair->pent2 != pent2 )
+		return NULL;
+
+	if ( pPair->serial1 != pent1->serialnumber || pPair->serial2 != pent2->serialnumber )
+		return NULL;
+
+	if ( pPair->time > gpGlobals->time )
+		return NULL; // left from the previous level
+
+	return pPair;
+}
+
+// same as FVisible, but the result is stored for the pair
+static BOOL SightTrace( CBaseEntity *pLooker, CBaseEntity *pTarget, const Vector &vecStart, const Vector &vecEnd )
+{
+	edict_t *pent1 = pLooker->edict();
+	edict_t *pent2 = pTarget->edict();
+	TraceResult tr;
+
+	UTIL_TraceLine( vecStart, vecEnd, ignore_monsters, ignore_glass, pent1, &tr );
+	g_iSightTraces++;
+
+	// LRC - monsters can "see" some bsp objects
+	BOOL visible = ( tr.flFraction == 1.0 || tr.pHit == pent2 );
+
+	if ( pent1 > pent2 )
+	{
+		edict_t *pTemp = pent1;
+		pent1 = pent2;
+		pent2 = pTemp;
+	}
+
+	sightpair_t *pPair = &g_SightPairs[SightHash( pent1, pent2 )];
+
+	pPair->pent1 = pent1;
+	pPair->pent2 = pent2;
+	pPair->serial1 = pent1->serialnumber;
+	pPair->serial2 = pent2->serialnumber;
+	pPair->vecStart = vecStart;
+	pPair->vecEnd = vecEnd;
+	pPair->frame = g_ulFrameCount;
+	pPair->time = gpGlobals->time;
+	pPair->visible = visible;
+
+	return visible;
+}
+
+//=========================================================
+// SightCheck - FVisible for the whole Look candidates list.
+// Sets pVisible[i] for each pList[i].
+//=========================================================
+static void SightCheck( CBaseEntity *pLooker, CBaseEntity **pList, int count, BOOL *pVisible )
+{
+	Vector	vecStart[MAX_SIGHT_QUERIES];
+	Vector	vecEnd[MAX_SIGHT_QUERIES];
+	float	flAge[MAX_SIGHT_QUERIES];
+	int	order[MAX_SIGHT_QUERIES];
+	int	i, j, numOrder = 0;
+	int	quota = 0;
+
+	SightBeginFrame();
+	g_iSightLookers++;
+	if ( ai_sight_stats.value )
+		g_iStatSightQueries += count;
+
+	if ( ai_sight_budget.value > 0 )
+	{
+		// everybody gets a trace, but only while the frame budget lasts
+		quota = max( (int)ai_sight_budget.value / g_iSightLastLookers, 1 );
+		quota = min( quota, (int)ai_sight_budget.value - g_iSightTraces );
+	}
+
+	for ( i = 0; i < count; i++ )
+	{
+		CBaseEntity *pTarget = pList[i];
+
+		pVisible[i] = FALSE;
+
+		// don't look through water
+		if (( pLooker->pev->waterlevel != 3 && pTarget->pev->waterlevel == 3 )
+			|| ( pLooker->pev->waterlevel == 3 && pTarget->pev->waterlevel == 0 ))
+			continue;
+
+		// a trace can hit a bsp entity, so it's not the same both ways
+		if ( pLooker->pev->solid == SOLID_BSP || pTarget->pev->solid == SOLID_BSP )
+		{
+			pVisible[i] = pLooker->FVisible( pTarget );
+			g_iSightTraces++;
+			continue;
+		}
+
+		vecStart[i] = pLooker->pev->origin + pLooker->pev->view_ofs; // look through the caller's 'eyes'
+		vecEnd[i] = pTarget->EyePosition();
+
+		sightpair_t *pPair = SightFindPair( pLooker->edict(), pTarget->edict() );
+
+		if ( pPair && pPair->frame == g_ulFrameCount )
+		{
+			// the other one of the pair has looked this frame along the same line
+			if (( pPair->vecStart == vecStart[i] && pPair->vecEnd == vecEnd[i] )
+			|| ( pPair->vecStart == vecEnd[i] && pPair->vecEnd == vecStart[i] ))
+			{
+				pVisible[i] = pPair->visible;
+				if ( ai_sight_stats.value )
+					g_iStatSightShared++;
+				continue;
+			}
+		}
+
+		if ( pPair )
+			flAge[i] = gpGlobals->time - pPair->time;
+		else flAge[i] = 99999.0f; // never traced, this is the oldest one
+
+		// oldest results first
+		for ( j = numOrder; j > 0 && flAge[order[j-1]] < flAge[i]; j-- )
+			order[j] = order[j-1];
+		order[j] = i;
+		numOrder++;
+	}
+
+	for ( j = 0; j < numOrder; j++ )
+	{
+		i = order[j];
+
+		if ( ai_sight_budget.value > 0 && quota <= 0 && flAge[i] <= ai_sight_maxage.value )
+		{
+			sightpair_t *pPair = SightFindPair( pLooker->edict(), pList[i]->edict() );
+
+			// the other pair may take this slot while we trace
+			if ( pPair )
+			{
+				pVisible[i] = pPair->visible;
+				if ( ai_sight_stats.value )
+					g_iStatSightDeferred++;
+				continue;
+			}
+		}
+
+		pVisible[i] = SightTrace( pLooker, pList[i], vecStart[i], vecEnd[i] );
+		quota--;
+	}
+}
+
 //=========================================================
 // Look - Base class monster function to find enemies or 
 // food by sight. iDistance is distance ( in units ) that the 
@@ -330,12 +560,16 @@ void CBaseMonster :: Look ( int iDistance )
 	if ( !FBitSet( pev->spawnflags, SF_MONSTER_PRISONER ) )
 	{
 		CBaseEntity *pList[100];
+		CBaseEntity *pCheck[MAX_SIGHT_QUERIES];
+		BOOL fVisible[MAX_SIGHT_QUERIES];
+		int checkCount = 0;
+		int i;
 
 		Vector delta = Vector( iDistance, iDistance, iDistance );
 
 		// Find only monsters/clients in box, NOT limited to PVS
 		int count = UTIL_EntitiesInBox( pList, 100, pev->origin - delta, pev->origin + delta, FL_CLIENT|FL_MONSTER );
-		for ( int i = 0; i < count; i++ )
+		for ( i = 0; i < count; i++ )
 		{
 			pSightEnt = pList[i];
 			// !!!temporarily only considering other monsters and clients, don't see prisoners
@@ -356,64 +590,75 @@ void CBaseMonster :: Look ( int iDistance )
 
 				// the looker will want to consider this entity
 				// don't check anything else about an entity that can't be seen, or an entity that you don't care about.
-				if ( IRelationship( pSightEnt ) != R_NO && FInViewCone( pSightEnt ) && !FBitSet( pSightEnt->pev->flags, FL_NOTARGET ) && FVisible( pSightEnt ) )
-				{
-					if ( pSightEnt->IsPlayer() )
-					{
-						if ( pev->spawnflags & SF_MONSTER_WAIT_TILL_SEEN )
-						{
-							CBaseMonster *pClient;
-
-							pClient = pSightEnt->MyMonsterPointer();
-							// don't link this client in the list if the monster is wait till seen and the player isn't facing the monster
-							if ( pSightEnt && !pClient->FInViewCone( this ) )
-							{
-								// we're not in the player's view cone. 
-								continue;
-							}
-							else
-							{
-								// player sees us, become normal now.
-								pev->spawnflags &= ~SF_MONSTER_WAIT_TILL_SEEN;
-							}
-						}
+				if ( IRelationship( pSightEnt ) != R_NO && FInViewCone( pSightEnt ) && !FBitSet( pSightEnt->pev->flags, FL_NOTARGET ) )
+					pCheck[checkCount++] = pSightEnt;
+			}
+		}
 
-						// if we see a client, remember that (mostly for scripted AI)
-						iSighted |= bits_COND_SEE_CLIENT;
-					}
+		// trace them all at once, so the results can be shared and deferred
+		SightCheck( this, pCheck, checkCount, fVisible );
+
+		for ( i = 0; i < checkCount; i++ )
+		{
+			if ( !fVisible[i] )
+				continue;
 
-					pSightEnt->m_pLink = m_pLink;
-					m_pLink = pSightEnt;
+			pSightEnt = pCheck[i];
 
-					if ( pSightEnt == m_hEnemy )
+			if ( pSightEnt->IsPlayer() )
+			{
+				if ( pev->spawnflags & SF_MONSTER_WAIT_TILL_SEEN )
+				{
+					CBaseMonster *pClient;
+
+					pClient = pSightEnt->MyMonsterPointer();
+					// don't link this client in the list if the monster is wait till seen and the player isn't facing the monster
+					if ( pSightEnt && !pClient->FInViewCone( this ) )
 					{
-						// we know this ent is visible, so if it also happens to be our enemy, store that now.
-						iSighted |= bits_COND_SEE_ENEMY;
+						// we're not in the player's view cone. 
+						continue;
 					}
-
-					// don't add the Enemy's relationship to the conditions. We only want to worry about conditions when
-					// we see monsters other than the Enemy.
-					switch ( IRelationship ( pSightEnt ) )
+					else
 					{
-					case	R_NM:
-						iSighted |= bits_COND_SEE_NEMESIS;		
-						break;
-					case	R_HT:	
-						iSighted |= bits_COND_SEE_HATE;		
-						break;
-					case	R_DL:
-						iSighted |= bits_COND_SEE_DISLIKE;
-						break;
-					case	R_FR:
-						iSighted |= bits_COND_SEE_FEAR;
-						break;
-					case    R_AL:
-						break;
-					default:
-						ALERT ( at_aiconsole, "%s can't assess %s\n", STRING(pev->classname), STRING(pSightEnt->pev->classname ) );
-						break;
+						// player sees us, become normal now.
+						pev->spawnflags &= ~SF_MONSTER_WAIT_TILL_SEEN;
 					}
 				}
+
+				// if we see a client, remember that (mostly for scripted AI)
+				iSighted |= bits_COND_SEE_CLIENT;
+			}
+
+			pSightEnt->m_pLink = m_pLink;
+			m_pLink = pSightEnt;
+
+			if ( pSightEnt == m_hEnemy )
+			{
+				// we know this ent is visible, so if it also happens to be our enemy, store that now.
+				iSighted |= bits_COND_SEE_ENEMY;
+			}
+
+			// don't add the Enemy's relationship to the conditions. We only want to worry about conditions when
+			// we see monsters other than the Enemy.
+			switch ( IRelationship ( pSightEnt ) )
+			{
+			case	R_NM:
+				iSighted |= bits_COND_SEE_NEMESIS;		
+				break;
+			case	R_HT:	
+				iSighted |= bits_COND_SEE_HATE;		
+				break;
+			case	R_DL:
+				iSighted |= bits_COND_SEE_DISLIKE;
+				break;
+			case	R_FR:
+				iSighted |= bits_COND_SEE_FEAR;
+				break;
+			case    R_AL:
+				break;
+			default:
+				ALERT ( at_aiconsole, "%s can't assess %s\n", STRING(pev->classname), STRING(pSightEnt->pev->classname ) );
+				break;
 			}
 		}
 	}
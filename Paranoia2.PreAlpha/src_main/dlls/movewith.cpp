@@ -4,20 +4,48 @@
 #include	"movewith.h"
 #include	"saverestore.h"
 #include	"player.h"
+#include	"game.h"
 
 CWorld *g_pWorld = NULL; //LRC
 
 BOOL g_doingDesired = FALSE; //LRC - marks whether the Desired functions are currently
 									// being processed.
 
+// sohl_mwstats counters, reported once per second
+static float	g_flAssistTime = 0.0f;
+static float	g_flDesiredTime = 0.0f;
+static int	g_iAssistCount = 0;	// list entries visited
+static int	g_iDesiredCount = 0;
+static int	g_iStatFrames = 0;
+static float	g_flNextStatReport = 0.0f;
+
+static void ReportMoveWithStats( void )
+{
+	if (gpGlobals->time < g_flNextStatReport && gpGlobals->time > g_flNextStatReport - 2.0f)
+		return;
+
+	if (g_iStatFrames)
+	{
+		ALERT(at_console, "MoveWith: %d frames, %.1f assist and %.1f desired ents, assist %.3f ms, desired %.3f ms per frame\n",
+			g_iStatFrames, (float)g_iAssistCount / g_iStatFrames, (float)g_iDesiredCount / g_iStatFrames,
+			g_flAssistTime * 1000.0f / g_iStatFrames, g_flDesiredTime * 1000.0f / g_iStatFrames);
+	}
+
+	g_flAssistTime = g_flDesiredTime = 0.0f;
+	g_iAssistCount = g_iDesiredCount = g_iStatFrames = 0;
+	g_flNextStatReport = gpGlobals->time + 1.0f;
+}
+
+// The AssistList is a doubly linked list headed by g_pWorld, and g_pWorld->m_pAssistTail
+// points to the last entry. An entity is in the list while its m_pAssistPrev is set.
 void UTIL_AddToAssistList( CBaseEntity *pEnt )
 {
 //	ALERT(at_console, "Add %s \"%s\" to AssistList\n", STRING(pEnt->pev->classname), STRING(pEnt->pev->targetname));
 
-	if (pEnt->m_pAssistLink)
+	if (pEnt->m_pAssistPrev)
 	{
 //		ALERT(at_console, "Ignored AddToAssistList for %s \"%s\"\n", STRING(pEnt->pev->classname), STRING(pEnt->pev->targetname));
-		return; // is pEnt already in the body of the list?
+		return; // is pEnt already in the list?
 	}
 
 	if ( !g_pWorld )
@@ -26,26 +54,35 @@ void UTIL_AddToAssistList( CBaseEntity *pEnt )
 		return;
 	}
 
-	CBaseEntity *pListMember = g_pWorld;
+	if (pEnt == g_pWorld)
+		return; // world is the list head
 
-	// find the last entry in the list...
-	while (pListMember->m_pAssistLink != NULL)
-		pListMember = pListMember->m_pAssistLink;
+	CBaseEntity *pTail = g_pWorld->m_pAssistTail;
 
-	if (pListMember == pEnt)
-	{
-//			ALERT(at_console, "(end)Ignored AddToAssistList for %s \"%s\"\n", STRING(pEnt->pev->classname), STRING(pEnt->pev->targetname));
-		return; // pEnt is the last entry in the list.
-	}
+	if (!pTail)
+		pTail = g_pWorld;
 
-	pListMember->m_pAssistLink = pEnt; // it's not in the list already, so add pEnt to the list.
-	
-//	int count = 0;
-//	for (pListMember = g_pWorld->m_pAssistLink; pListMember; pListMember = pListMember->m_pAssistLink)
-//	{
-//		count++;
-//	}
-//	ALERT(at_console, "Added %s \"%s\" to AssistList, length now %d\n", STRING(pEnt->pev->classname), STRING(pEnt->pev->targetname), count);
+	pTail->m_pAssistLink = pEnt; // add pEnt to the end of the list.
+	pEnt->m_pAssistPrev = pTail;
+	pEnt->m_pAssistLink = NULL;
+	g_pWorld->m_pAssistTail = pEnt;
+}
+
+void UTIL_RemoveFromAssistList( CBaseEntity *pEnt )
+{
+	if (!pEnt->m_pAssistPrev || !g_pWorld)
+		return; // not in the list
+
+//	ALERT(at_console, "Removing %s \"%s\" from assistList\n", STRING(pEnt->pev->classname), STRING(pEnt->pev->targetname));
+	pEnt->m_pAssistPrev->m_pAssistLink = pEnt->m_pAssistLink;
+
+	if (pEnt->m_pAssistLink)
+		pEnt->m_pAssistLink->m_pAssistPrev = pEnt->m_pAssistPrev;
+	else
+		g_pWorld->m_pAssistTail = pEnt->m_pAssistPrev;
+
+	pEnt->m_pAssistLink = NULL;
+	pEnt->m_pAssistPrev = NULL;
 }
 
 void HandlePostAssist( CBaseEntity *pEnt )
@@ -266,6 +303,8 @@ int TryAssistEntity( CBaseEntity *pEnt )
 void CheckAssistList( void )
 {
 	CBaseEntity *pListMember;
+	CBaseEntity *pNext;
+	float flStart = 0.0f;
 
 	if ( !g_pWorld )
 	{
@@ -273,36 +312,28 @@ void CheckAssistList( void )
 		return;
 	}
 
-	int count = 0;
-
-	for (pListMember = g_pWorld; pListMember; pListMember = pListMember->m_pAssistLink)
+	if (mw_stats.value)
 	{
-		if (pListMember->m_iLFlags & LF_DOASSIST)
-			count++;
+		ReportMoveWithStats();
+		flStart = SYS_TIME();
+		g_iStatFrames++;
 	}
-//	if (count)
-//		ALERT(at_console, "CheckAssistList begins, length is %d\n", count);
-	count = 0;
-	pListMember = g_pWorld;
 
-	while ( pListMember->m_pAssistLink ) // handle the remaining entries in the list
+	for (pListMember = g_pWorld->m_pAssistLink; pListMember; pListMember = pNext)
 	{
-		TryAssistEntity(pListMember->m_pAssistLink);
-		if (!(pListMember->m_pAssistLink->m_iLFlags & LF_ASSISTLIST))
-		{
-//			ALERT(at_console, "Removing %s \"%s\" from assistList\n", STRING(pListMember->m_pAssistLink->pev->classname), STRING(pListMember->m_pAssistLink->pev->targetname));
-			CBaseEntity *pTemp = pListMember->m_pAssistLink;
-			pListMember->m_pAssistLink = pListMember->m_pAssistLink->m_pAssistLink;
-			pTemp->m_pAssistLink = NULL;
-		}
-		else
-		{
-			pListMember = pListMember->m_pAssistLink;
-		}
+		TryAssistEntity(pListMember);
+
+		// take the next one after TryAssistEntity, it may add some entries
+		pNext = pListMember->m_pAssistLink;
+
+		if (!(pListMember->m_iLFlags & LF_ASSISTLIST))
+			UTIL_RemoveFromAssistList(pListMember);
+		if (mw_stats.value)
+			g_iAssistCount++;
 	}
 
-//	if (count)
-//		ALERT(at_console, "CheckAssistList complete, %d ents checked\n", count);
+	if (mw_stats.value)
+		g_flAssistTime += SYS_TIME() - flStart;
 }
 
 // called every frame, by PostThink
@@ -320,8 +351,11 @@ void CheckDesiredList( void )
 		ALERT(at_console, "CheckDesiredList has no AssistList!\n");
 		return;
 	}
-	pListMember = g_pWorld;
 	CBaseEntity *pNext;
+	float flStart = 0.0f;
+
+	if (mw_stats.value)
+		flStart = SYS_TIME();
 
 //	int count = 0;
 //	int all = 0;
@@ -342,6 +376,8 @@ void CheckDesiredList( void )
 		pNext = pListMember->m_pAssistLink;
 		ApplyDesiredSettings( pListMember );
 		pListMember = pNext;
+		if (mw_stats.value)
+			g_iDesiredCount++;
 		loopbreaker--;
 		if (loopbreaker <= 0)
 		{
@@ -354,6 +390,9 @@ void CheckDesiredList( void )
 
 //	if (liststart) ALERT(at_console, "-- DesiredList ends\n");
 	g_doingDesired = FALSE;
+
+	if (mw_stats.value)
+		g_flDesiredTime += SYS_TIME() - flStart;
 }
 
 
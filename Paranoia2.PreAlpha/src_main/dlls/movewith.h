@@ -29,6 +29,7 @@ extern void			UTIL_DesiredInfo ( CBaseEntity *pEnt );
 extern void			UTIL_DesiredPostAssist ( CBaseEntity *pEnt );
 
 extern void			UTIL_AddToAssistList ( CBaseEntity *pEnt );
+extern void			UTIL_RemoveFromAssistList ( CBaseEntity *pEnt );
 
 
 extern void			UTIL_MarkForAssist ( CBaseEntity *pEnt, BOOL correctSpeed );
@@ -26,6 +26,7 @@
 #include	"nodes.h"
 #include	"animation.h"
 #include	"doors.h"
+#include	"game.h"
 
 #define	HULL_STEP_SIZE 16// how far the test hull moves on each step
 #define	NODE_HEIGHT	8	// how high to lift nodes off the ground after we drop them all (make stair/ramp mapping easier)
@@ -106,6 +107,9 @@ void CGraph :: InitGraph( void)
 
 	m_iLastActiveIdleSearch = 0;
 	m_iLastCoverSearch = 0;
+
+	FreePathSearch();
+	FreeNodeTree();
 }
 	
 //=========================================================
@@ -570,6 +574,324 @@ int CGraph::NextNodeInRoute( int iCurrentNode, int iDest, int iHull, int iCap )
 }
 
 
+//=========================================================
+// Path search state. It's kept out of CNode and CGraph
+// because both are written into the .nod file as is.
+//=========================================================
+typedef struct
+{
+	int	Id;
+	float	Priority;	// cost so far + estimate to the destination
+	float	Cost;	// cost so far when the node was pushed
+} OPEN_NODE;
+
+typedef struct
+{
+	OPEN_NODE	*pItems;	// binary heap, smallest priority first
+	int	cItems;
+	int	nItems;	// allocated size
+} OPEN_HEAP;
+
+static int	*s_pSearchGen = NULL;	// node was reached by the search with this number
+static int	s_iSearchGen = 0;
+static OPEN_HEAP	s_OpenHeap;			// A* open list
+static short	*s_pComponent[MAX_NODE_HULLS];	// connected group of the node for every hull
+static int	s_cSearchNodes = 0;
+static int	s_cSearchLinks = 0;
+
+static void HeapInsert( OPEN_HEAP *pHeap, int iId, float flPriority, float flCost )
+{
+	if ( pHeap->cItems == pHeap->nItems )
+	{
+		ALERT( at_aiconsole, "Node heap is full!\n" );
+		return;
+	}
+
+	OPEN_NODE *pItems = pHeap->pItems;
+	int child = pHeap->cItems++;
+
+	while ( child )
+	{
+		int parent = (child - 1) / 2;
+		if ( pItems[parent].Priority <= flPriority )
+			break;
+		pItems[child] = pItems[parent];
+		child = parent;
+	}
+
+	pItems[child].Id = iId;
+	pItems[child].Priority = flPriority;
+	pItems[child].Cost = flCost;
+}
+
+static OPEN_NODE HeapRemove( OPEN_HEAP *pHeap )
+{
+	OPEN_NODE *pItems = pHeap->pItems;
+	OPEN_NODE Top = pItems[0];
+	OPEN_NODE Ref = pItems[--pHeap->cItems];
+	int parent = 0;
+	int child = 1;
+
+	while ( child < pHeap->cItems )
+	{
+		if ( child + 1 < pHeap->cItems && pItems[child+1].Priority < pItems[child].Priority )
+			child++;
+		if ( Ref.Priority <= pItems[child].Priority )
+			break;
+		pItems[parent] = pItems[child];
+		parent = child;
+		child = 2 * parent + 1;
+	}
+
+	pItems[parent] = Ref;
+	return Top;
+}
+
+static int FindGroup( int *pGroups, int i )
+{
+	while ( pGroups[i] != i )
+	{
+		pGroups[i] = pGroups[pGroups[i]];
+		i = pGroups[i];
+	}
+	return i;
+}
+
+//=========================================================
+// CGraph - FreePathSearch - releases the search buffers,
+// they will be rebuilt by the next search.
+//=========================================================
+void CGraph :: FreePathSearch( void )
+{
+	free( s_pSearchGen );
+	free( s_OpenHeap.pItems );
+	s_pSearchGen = NULL;
+	s_OpenHeap.pItems = NULL;
+
+	for ( int i = 0; i < MAX_NODE_HULLS; i++ )
+	{
+		free( s_pComponent[i] );
+		s_pComponent[i] = NULL;
+	}
+
+	s_cSearchNodes = s_cSearchLinks = 0;
+	s_OpenHeap.cItems = s_OpenHeap.nItems = 0;
+	s_iSearchGen = 0;
+}
+
+//=========================================================
+// CGraph - AllocPathSearch - allocates the search buffers
+// and splits the nodes into the groups which are connected
+// for the each hull. Link ents are treated as passable, so
+// if two nodes are in different groups there is no path
+// between them at all. This is our abstract graph: a search
+// between the groups fails without touching any node.
+//=========================================================
+BOOL CGraph :: AllocPathSearch( void )
+{
+	int *pGroups;
+	int i, iHull;
+
+	if ( s_pSearchGen && s_cSearchNodes == m_cNodes && s_cSearchLinks == m_cLinks )
+		return TRUE;
+
+	FreePathSearch();
+
+	s_pSearchGen = (int *)calloc( m_cNodes, sizeof( int ));
+	s_OpenHeap.nItems = m_cLinks + m_cNodes + 1;
+	s_OpenHeap.pItems = (OPEN_NODE *)malloc( s_OpenHeap.nItems * sizeof( OPEN_NODE ));
+	pGroups = (int *)malloc( m_cNodes * sizeof( int ));
+
+	for ( iHull = 0; iHull < MAX_NODE_HULLS; iHull++ )
+		s_pComponent[iHull] = (short *)malloc( m_cNodes * sizeof( short ));
+
+	if ( !s_pSearchGen || !s_OpenHeap.pItems || !pGroups || !s_pComponent[MAX_NODE_HULLS-1] )
+	{
+		ALERT ( at_aiconsole, "Couldn't malloc path search buffers!\n" );
+		free( pGroups );
+		FreePathSearch();
+		return FALSE;
+	}
+
+	for ( iHull = 0; iHull < MAX_NODE_HULLS; iHull++ )
+	{
+		int iHullMask = bits_LINK_SMALL_HULL << iHull;
+
+		for ( i = 0; i < m_cNodes; i++ )
+			pGroups[i] = i;
+
+		for ( i = 0; i < m_cLinks; i++ )
+		{
+			if (( m_pLinkPool[i].m_afLinkInfo & iHullMask ) != iHullMask )
+				continue;
+
+			int iSrc = FindGroup( pGroups, m_pLinkPool[i].m_iSrcNode );
+			int iDest = FindGroup( pGroups, m_pLinkPool[i].m_iDestNode );
+			if ( iSrc != iDest )
+				pGroups[iSrc] = iDest;
+		}
+
+		for ( i = 0; i < m_cNodes; i++ )
+			s_pComponent[iHull][i] = FindGroup( pGroups, i );
+	}
+
+	free( pGroups );
+
+	s_cSearchNodes = m_cNodes;
+	s_cSearchLinks = m_cLinks;
+
+	return TRUE;
+}
+
+//=========================================================
+// CGraph - PathEstimate - straight line estimate for A*.
+// Link weights are 2D distances, so it never overestimates.
+//=========================================================
+inline float CGraph :: PathEstimate( int iNode, int iDest )
+{
+	return ( m_pNodes[ iDest ].m_vecOrigin - m_pNodes[ iNode ].m_vecOrigin ).Make2D().Length();
+}
+
+//=========================================================
+// CGraph - SearchPaths - A* search from iStart. When iDest
+// is NO_NODE it finds the shortest paths to every reachable
+// node. The paths are left in m_iPreviousNode of the nodes
+// which were reached (have the current search number).
+//=========================================================
+BOOL CGraph :: SearchPaths( int iStart, int iDest, int iHull, int afCapMask )
+{
+	int		iVisitNode;
+	int		iCurrentNode;
+	int		iHullMask;
+
+	switch( iHull )
+	{
+	case NODE_SMALL_HULL:
+		iHullMask = bits_LINK_SMALL_HULL;
+		break;
+	case NODE_HUMAN_HULL:
+		iHullMask = bits_LINK_HUMAN_HULL;
+		break;
+	case NODE_LARGE_HULL:
+		iHullMask = bits_LINK_LARGE_HULL;
+		break;
+	case NODE_FLY_HULL:
+		iHullMask = bits_LINK_FLY_HULL;
+		break;
+	}
+
+	if ( !AllocPathSearch() )
+		return FALSE;
+
+	// not connected at all?
+	if ( iDest != NO_NODE && s_pComponent[ iHull ][ iStart ] != s_pComponent[ iHull ][ iDest ] )
+		return FALSE;
+
+	// Mark all the nodes as unvisited: nodes which have an older
+	// search number are unvisited, m_flClosestSoFar is only valid
+	// for the nodes with the current one.
+	//
+	if ( ++s_iSearchGen <= 0 )
+	{
+		memset( s_pSearchGen, 0, m_cNodes * sizeof( int ));
+		s_iSearchGen = 1;
+	}
+
+	int i = 0;
+
+	m_pNodes[ iStart ].m_flClosestSoFar = 0.0;
+	m_pNodes[ iStart ].m_iPreviousNode = iStart;// tag this as the origin node
+	s_pSearchGen[ iStart ] = s_iSearchGen;
+
+	s_OpenHeap.cItems = 0;
+	HeapInsert( &s_OpenHeap, iStart, ( iDest != NO_NODE ) ? PathEstimate( iStart, iDest ) : 0.0f, 0.0 );// insert start node 
+	
+	while ( s_OpenHeap.cItems )
+	{
+		// now pull a node out of the queue
+		OPEN_NODE Open = HeapRemove( &s_OpenHeap );
+		iCurrentNode = Open.Id;
+
+		// With the straight line estimate the first time we pull
+		// the destination out we have the shortest path to it.
+		// Without the destination the search covers all the
+		// reachable nodes.
+		//
+		if (iCurrentNode == iDest) break;
+
+		CNode *pCurrentNode = &m_pNodes[ iCurrentNode ];
+		float flCurrentDistance = pCurrentNode->m_flClosestSoFar;
+
+		// the node was reached cheaper after this was queued
+		if ( Open.Cost > flCurrentDistance + 0.001 )
+			continue;
+		
+		for ( i = 0 ; i < pCurrentNode->m_cNumLinks ; i++ )
+		{// run through all of this node's neighbors
+			CLink *pLink = &m_pLinkPool[ pCurrentNode->m_iFirstLink + i ];
+			
+			iVisitNode = pLink->m_iDestNode;
+			if ( ( pLink->m_afLinkInfo & iHullMask ) != iHullMask )
+			{// monster is too large to walk this connection
+				continue;
+			}
+			// check the connection from the current node to the node we're about to mark visited and push into the queue				
+			if ( pLink->m_pLinkEnt != NULL )
+			{// there's a brush ent in the way! Don't mark this node or put it into the queue unless the monster can negotiate it
+				
+				if ( !HandleLinkEnt ( iCurrentNode, pLink->m_pLinkEnt, afCapMask, NODEGRAPH_STATIC ) )
+				{// monster should not try to go this way.
+					continue;
+				}
+			}
+			float flOurDistance = flCurrentDistance + pLink->m_flWeight;
+			if (  s_pSearchGen[ iVisitNode ] != s_iSearchGen
+			   || flOurDistance < m_pNodes[ iVisitNode ].m_flClosestSoFar - 0.001 )
+			{
+				s_pSearchGen[ iVisitNode ] = s_iSearchGen;
+				m_pNodes[iVisitNode].m_flClosestSoFar = flOurDistance;
+				m_pNodes[iVisitNode].m_iPreviousNode = iCurrentNode;
+
+				HeapInsert( &s_OpenHeap, iVisitNode, ( iDest != NO_NODE ) ? flOurDistance + PathEstimate( iVisitNode, iDest ) : flOurDistance, flOurDistance );
+			}
+		}
+	}
+	if ( iDest != NO_NODE && s_pSearchGen[ iDest ] != s_iSearchGen )
+		return FALSE;
+
+	return TRUE;
+}
+
+//=========================================================
+// CGraph - CopyPath - copies the path found by SearchPaths
+// into piPath, returns the number of nodes in it.
+//=========================================================
+int CGraph :: CopyPath( int *piPath, int iStart, int iDest )
+{
+	int		iCurrentNode;
+	int		iNumPathNodes;
+	int		i;
+
+	// now we must walk backwards through the m_iPreviousNode field, and count how many connections there are in the path
+	iCurrentNode = iDest;
+	iNumPathNodes = 1;// count the dest
+	
+	while ( iCurrentNode != iStart )
+	{
+		iNumPathNodes++;
+		iCurrentNode = m_pNodes[ iCurrentNode ].m_iPreviousNode;
+	}
+
+	iCurrentNode = iDest;
+	for ( i = iNumPathNodes - 1 ; i >= 0 ; i-- )
+	{
+		piPath[ i ] = iCurrentNode;
+		iCurrentNode = m_pNodes [ iCurrentNode ].m_iPreviousNode;
+	}
+
+	return iNumPathNodes;
+}
+
 //=========================================================
 // CGraph - FindShortestPath 
 //
@@ -579,10 +901,8 @@ int CGraph::NextNodeInRoute( int iCurrentNode, int iDest, int iHull, int iCap )
 //=========================================================
 int CGraph :: FindShortestPath ( int *piPath, int iStart, int iDest, int iHull, int afCapMask)
 {
-	int		iVisitNode;
 	int		iCurrentNode;
 	int		iNumPathNodes;
-	int		iHullMask;
 
 	if ( !m_fGraphPresent || !m_fGraphPointersSet )
 	{// protect us in the case that the node graph isn't available or built
@@ -639,101 +959,12 @@ int CGraph :: FindShortestPath ( int *piPath, int iStart, int iDest, int iHull,
 	}
 	else
 	{
-		CQueuePriority	queue;
-
-		switch( iHull )
-		{
-		case NODE_SMALL_HULL:
-			iHullMask = bits_LINK_SMALL_HULL;
-			break;
-		case NODE_HUMAN_HULL:
-			iHullMask = bits_LINK_HUMAN_HULL;
-			break;
-		case NODE_LARGE_HULL:
-			iHullMask = bits_LINK_LARGE_HULL;
-			break;
-		case NODE_FLY_HULL:
-			iHullMask = bits_LINK_FLY_HULL;
-			break;
-		}
-
-		// Mark all the nodes as unvisited.
-		//
-		int i = 0;
-		for ( i = 0; i < m_cNodes; i++)
-		{
-			m_pNodes[ i ].m_flClosestSoFar = -1.0;
-		}
-
-		m_pNodes[ iStart ].m_flClosestSoFar = 0.0;
-		m_pNodes[ iStart ].m_iPreviousNode = iStart;// tag this as the origin node
-		queue.Insert( iStart, 0.0 );// insert start node 
-		
-		while ( !queue.Empty() )
-		{
-			// now pull a node out of the queue
-			float flCurrentDistance;
-			iCurrentNode = queue.Remove(flCurrentDistance);
-
-			// For straight-line weights, the following Shortcut works. For arbitrary weights,
-			// it doesn't.
-			//
-			if (iCurrentNode == iDest) break;
-
-			CNode *pCurrentNode = &m_pNodes[ iCurrentNode ];
-			
-			for ( i = 0 ; i < pCurrentNode->m_cNumLinks ; i++ )
-			{// run through all of this node's neighbors
-				
-				iVisitNode = INodeLink ( iCurrentNode, i );
-				if ( ( m_pLinkPool[  m_pNodes[ iCurrentNode ].m_iFirstLink + i ].m_afLinkInfo & iHullMask ) != iHullMask )
-				{// monster is too large to walk this connection
-					//ALERT ( at_aiconsole, "fat ass %d/%d\n",m_pLinkPool[ m_pNodes[ iCurrentNode ].m_iFirstLink + i ].m_afLinkInfo, iMonsterHull );
-					continue;
-				}
-				// check the connection from the current node to the node we're about to mark visited and push into the queue				
-				if ( m_pLinkPool[ m_pNodes[ iCurrentNode ].m_iFirstLink + i ].m_pLinkEnt != NULL )
-				{// there's a brush ent in the way! Don't mark this node or put it into the queue unless the monster can negotiate it
-					
-					if ( !HandleLinkEnt ( iCurrentNode, m_pLinkPool[ m_pNodes[ iCurrentNode ].m_iFirstLink + i ].m_pLinkEnt, afCapMask, NODEGRAPH_STATIC ) )
-					{// monster should not try to go this way.
-						continue;
-					}
-				}
-				float flOurDistance = flCurrentDistance + m_pLinkPool[ m_pNodes[ iCurrentNode ].m_iFirstLink + i].m_flWeight;
-				if (  m_pNodes[ iVisitNode ].m_flClosestSoFar < -0.5
-				   || flOurDistance < m_pNodes[ iVisitNode ].m_flClosestSoFar - 0.001 )
-				{
-					m_pNodes[iVisitNode].m_flClosestSoFar = flOurDistance;
-					m_pNodes[iVisitNode].m_iPreviousNode = iCurrentNode;
-
-					queue.Insert ( iVisitNode, flOurDistance );
-				}
-			}
-		}
-		if ( m_pNodes[iDest].m_flClosestSoFar < -0.5 )
+		if ( !SearchPaths( iStart, iDest, iHull, afCapMask ))
 		{// Destination is unreachable, no path found.
 			return 0;
 		}
 
-	// the queue is not empty
-		
-		// now we must walk backwards through the m_iPreviousNode field, and count how many connections there are in the path
-		iCurrentNode = iDest;
-		iNumPathNodes = 1;// count the dest
-		
-		while ( iCurrentNode != iStart )
-		{
-			iNumPathNodes++;
-			iCurrentNode = m_pNodes[ iCurrentNode ].m_iPreviousNode;
-		}
-
-		iCurrentNode = iDest;
-		for ( i = iNumPathNodes - 1 ; i >= 0 ; i-- )
-		{
-			piPath[ i ] = iCurrentNode;
-			iCurrentNode = m_pNodes [ iCurrentNode ].m_iPreviousNode;
-		}
+		iNumPathNodes = CopyPath( piPath, iStart, iDest );
 	}
 
 #if 0
@@ -784,21 +1015,6 @@ inline ULONG Hash(void *p, int len)
 	return CRC32_FINAL(ulCrc);
 }
 
-void inline CalcBounds(int &Lower, int &Upper, int Goal, int Best)
-{
-    int Temp = 2*Goal - Best;
-    if (Best > Goal)
-    {
-        Lower = max(0, Temp);
-        Upper = Best;
-    }
-    else
-    {
-        Upper = min(255, Temp);
-        Lower = Best;
-    }
-}
-
 // Convert from [-8192,8192] to [0, 255]
 //
 inline int CALC_RANGE(int x, int lower, int upper)
@@ -806,66 +1022,182 @@ inline int CALC_RANGE(int x, int lower, int upper)
 	return NUM_RANGES*(x-lower)/((upper-lower+1));
 }
 
+//=========================================================
+// Node KD-tree for FindNearestNode. Cells split the nodes
+// by the median of the longest side until a few are left.
+// Like the path search state it lives outside of CGraph.
+//=========================================================
+#define NODETREE_LEAF_SIZE	8
 
-void inline UpdateRange(int &minValue, int &maxValue, int Goal, int Best)
+typedef struct
 {
-    int Lower, Upper;
-    CalcBounds(Lower, Upper, Goal, Best);
-    if (Upper < maxValue) maxValue = Upper;
-    if (minValue < Lower) minValue = Lower;
+	Vector	mins, maxs;	// bounds of m_vecOriginPeek of the nodes inside
+	int	afNodeInfo;	// all the node types inside
+	int	iFirstNode;	// first entry in s_pTreeNodes
+	int	cNodes;
+	int	iChildren[2];	// -1 for the leafs
+} NODETREE_CELL;
+
+static NODETREE_CELL	*s_pTreeCells = NULL;
+static int		*s_pTreeNodes = NULL;	// node indices in the leaf order
+static int		s_cTreeCells = 0;
+static OPEN_HEAP		s_NearestHeap;		// cells and nodes by the distance
+static int		s_iTreeSerial = 0;		// changes with every graph, for the monster hints
+static CNode		*s_pSortNodes;
+static int		s_iSortAxis;
+
+static int NodeTreeCompare( const void *a, const void *b )
+{
+	float fa = s_pSortNodes[*(const int *)a].m_vecOriginPeek[s_iSortAxis];
+	float fb = s_pSortNodes[*(const int *)b].m_vecOriginPeek[s_iSortAxis];
+
+	if ( fa < fb ) return -1;
+	if ( fa > fb ) return 1;
+	return 0;
 }
 
-void CGraph :: CheckNode(Vector vecOrigin, int iNode)
+static int BuildNodeTreeCell( CNode *pNodes, int iFirst, int cNodes )
 {
-    // Have we already seen this point before?.
-    //
-    if (m_di[iNode].m_CheckedEvent == m_CheckedCounter) return;
-    m_di[iNode].m_CheckedEvent = m_CheckedCounter;
+	int iCell = s_cTreeCells++;
+	NODETREE_CELL *pCell = &s_pTreeCells[iCell];
+	int i;
 
-	float flDist = ( vecOrigin - m_pNodes[ iNode ].m_vecOriginPeek ).Length();
+	pCell->mins = pCell->maxs = pNodes[s_pTreeNodes[iFirst]].m_vecOriginPeek;
+	pCell->afNodeInfo = 0;
+	pCell->iFirstNode = iFirst;
+	pCell->cNodes = cNodes;
+	pCell->iChildren[0] = pCell->iChildren[1] = -1;
 
-	if ( flDist < m_flShortest )
+	for ( i = iFirst; i < iFirst + cNodes; i++ )
 	{
-		TraceResult tr;
+		CNode *pNode = &pNodes[s_pTreeNodes[i]];
 
-		// make sure that vecOrigin can trace to this node!
-		UTIL_TraceLine ( vecOrigin, m_pNodes[ iNode ].m_vecOriginPeek, ignore_monsters, 0, &tr );
-
-		if ( tr.flFraction == 1.0 )
+		for ( int j = 0; j < 3; j++ )
 		{
-			m_iNearest = iNode;
-			m_flShortest = flDist;
+			if ( pNode->m_vecOriginPeek[j] < pCell->mins[j] ) pCell->mins[j] = pNode->m_vecOriginPeek[j];
+			if ( pNode->m_vecOriginPeek[j] > pCell->maxs[j] ) pCell->maxs[j] = pNode->m_vecOriginPeek[j];
+		}
+		pCell->afNodeInfo |= pNode->m_afNodeInfo;
+	}
 
-			UpdateRange(m_minX, m_maxX, CALC_RANGE(vecOrigin.x, m_RegionMin[0], m_RegionMax[0]), m_pNodes[iNode].m_Region[0]);
-			UpdateRange(m_minY, m_maxY, CALC_RANGE(vecOrigin.y, m_RegionMin[1], m_RegionMax[1]), m_pNodes[iNode].m_Region[1]);
-			UpdateRange(m_minZ, m_maxZ, CALC_RANGE(vecOrigin.z, m_RegionMin[2], m_RegionMax[2]), m_pNodes[iNode].m_Region[2]);
+	if ( cNodes <= NODETREE_LEAF_SIZE )
+		return iCell;
 
-			// From maxCircle, calculate maximum bounds box. All points must be
-			// simultaneously inside all bounds of the box.
-			//
-			m_minBoxX = CALC_RANGE(vecOrigin.x - flDist, m_RegionMin[0], m_RegionMax[0]);
-			m_maxBoxX = CALC_RANGE(vecOrigin.x + flDist, m_RegionMin[0], m_RegionMax[0]);
-			m_minBoxY = CALC_RANGE(vecOrigin.y - flDist, m_RegionMin[1], m_RegionMax[1]);
-			m_maxBoxY = CALC_RANGE(vecOrigin.y + flDist, m_RegionMin[1], m_RegionMax[1]);
-			m_minBoxZ = CALC_RANGE(vecOrigin.z - flDist, m_RegionMin[2], m_RegionMax[2]);
-			m_maxBoxZ = CALC_RANGE(vecOrigin.z + flDist, m_RegionMin[2], m_RegionMax[2]);
-		}
+	Vector vecSize = pCell->maxs - pCell->mins;
+
+	s_iSortAxis = 0;
+	if ( vecSize.y > vecSize[s_iSortAxis] ) s_iSortAxis = 1;
+	if ( vecSize.z > vecSize[s_iSortAxis] ) s_iSortAxis = 2;
+	s_pSortNodes = pNodes;
+
+	qsort( s_pTreeNodes + iFirst, cNodes, sizeof( int ), NodeTreeCompare );
+
+	int iLeft = BuildNodeTreeCell( pNodes, iFirst, cNodes / 2 );
+	int iRight = BuildNodeTreeCell( pNodes, iFirst + cNodes / 2, cNodes - cNodes / 2 );
+
+	s_pTreeCells[iCell].iChildren[0] = iLeft;
+	s_pTreeCells[iCell].iChildren[1] = iRight;
+
+	return iCell;
+}
+
+static float CellDistance( const NODETREE_CELL *pCell, const Vector &vecOrigin )
+{
+	float flDist = 0.0f;
+
+	for ( int i = 0; i < 3; i++ )
+	{
+		float d = 0.0f;
+
+		if ( vecOrigin[i] < pCell->mins[i] )
+			d = pCell->mins[i] - vecOrigin[i];
+		else if ( vecOrigin[i] > pCell->maxs[i] )
+			d = vecOrigin[i] - pCell->maxs[i];
+		flDist += d * d;
 	}
+
+	return sqrt( flDist );
+}
+
+//=========================================================
+// CGraph - FreeNodeTree
+//=========================================================
+void CGraph :: FreeNodeTree( void )
+{
+	free( s_pTreeCells );
+	free( s_pTreeNodes );
+	free( s_NearestHeap.pItems );
+	s_pTreeCells = NULL;
+	s_pTreeNodes = NULL;
+	s_NearestHeap.pItems = NULL;
+	s_NearestHeap.cItems = s_NearestHeap.nItems = 0;
+	s_cTreeCells = 0;
+}
+
+//=========================================================
+// CGraph - BuildNodeTree - builds the KD-tree over the node
+// positions. Called when the graph pointers are set.
+//=========================================================
+BOOL CGraph :: BuildNodeTree( void )
+{
+	FreeNodeTree();
+
+	if ( m_cNodes <= 0 )
+		return FALSE;
+
+	s_pTreeCells = (NODETREE_CELL *)malloc( 2 * m_cNodes * sizeof( NODETREE_CELL ));
+	s_pTreeNodes = (int *)malloc( m_cNodes * sizeof( int ));
+	s_NearestHeap.nItems = 3 * m_cNodes + 1;
+	s_NearestHeap.pItems = (OPEN_NODE *)malloc( s_NearestHeap.nItems * sizeof( OPEN_NODE ));
+
+	if ( !s_pTreeCells || !s_pTreeNodes || !s_NearestHeap.pItems )
+	{
+		ALERT ( at_aiconsole, "Couldn't malloc node tree!\n" );
+		FreeNodeTree();
+		return FALSE;
+	}
+
+	for ( int i = 0; i < m_cNodes; i++ )
+		s_pTreeNodes[i] = i;
+
+	BuildNodeTreeCell( m_pNodes, 0, m_cNodes );
+	s_iTreeSerial++;
+
+	return TRUE;
 }
 
 //=========================================================
 // CGraph - FindNearestNode - returns the index of the node nearest
 // the given vector -1 is failure (couldn't find a valid
 // near node )
+//
+// Monsters remember their last result. A monster usually
+// stays near it, so it seeds the search with a distance
+// bound and the farther cells are never opened.
 //=========================================================
 int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  CBaseEntity *pEntity )
 {
-	return FindNearestNode( vecOrigin, NodeType( pEntity ) );
+	CBaseMonster *pMonster = pEntity ? pEntity->MyMonsterPointer() : NULL;
+	int afNodeTypes = NodeType( pEntity );
+	int iSeed = -1;
+
+	if ( pMonster && s_pTreeCells && pMonster->m_iNearestNodeGraph == s_iTreeSerial && pMonster->m_afNearestNodeTypes == afNodeTypes )
+		iSeed = pMonster->m_iNearestNode;
+
+	int iNearest = FindNearestNode( vecOrigin, afNodeTypes, iSeed );
+
+	if ( pMonster && s_pTreeCells && iNearest != -1 )
+	{
+		pMonster->m_iNearestNode = iNearest;
+		pMonster->m_afNearestNodeTypes = afNodeTypes;
+		pMonster->m_iNearestNodeGraph = s_iTreeSerial;
+	}
+
+	return iNearest;
 }
 
-int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  int afNodeTypes )
+int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  int afNodeTypes, int iSeed )
 {
-	int	i;
 	TraceResult tr;
 
 	if ( !m_fGraphPresent || !m_fGraphPointersSet )
@@ -887,187 +1219,78 @@ int	CGraph :: FindNearestNode ( const Vector &vecOrigin,  int afNodeTypes )
 		//ALERT(at_aiconsole, "Cache Miss.\n");
 	}
 
-	// Mark all points as unchecked.
+	if ( !s_pTreeCells && !BuildNodeTree() )
+		return -1;
+
+	m_iNearest = -1;
+	m_flShortest = 999999.0f;
+
+	// A visible seed node bounds the search: only the nodes nearer
+	// than it are worth a trace, and the farther cells are skipped.
 	//
-	m_CheckedCounter++;
-	if (m_CheckedCounter == 0)
+	if ( iSeed >= 0 && iSeed < m_cNodes && ( m_pNodes[ iSeed ].m_afNodeInfo & afNodeTypes ))
 	{
-		for (int i = 0; i < m_cNodes; i++)
+		UTIL_TraceLine ( vecOrigin, m_pNodes[ iSeed ].m_vecOriginPeek, ignore_monsters, 0, &tr );
+
+		if ( tr.flFraction == 1.0 )
 		{
-			m_di[i].m_CheckedEvent = 0;
+			m_iNearest = iSeed;
+			m_flShortest = ( vecOrigin - m_pNodes[ iSeed ].m_vecOriginPeek ).Length();
 		}
-		m_CheckedCounter++;
 	}
 
-	m_iNearest = -1;
-	m_flShortest = 999999.0; // just a big number.
-
-	// If we can find a visible point, then let CalcBounds set the limits, but if
-	// we have no visible point at all to start with, then don't restrict the limits.
+	// Walk the tree nearest first: cells go into the heap by the distance to
+	// their bounds, nodes by their own distance. So the nodes come out in the
+	// distance order and the first one we can trace to is the nearest one.
 	//
-#if 1
-	m_minX = 0; m_maxX = 255;
-	m_minY = 0; m_maxY = 255;
-	m_minZ = 0; m_maxZ = 255;
-	m_minBoxX = 0; m_maxBoxX = 255;
-	m_minBoxY = 0; m_maxBoxY = 255;
-	m_minBoxZ = 0; m_maxBoxZ = 255;
-#else
-	m_minBoxX = CALC_RANGE(vecOrigin.x - flDist, m_RegionMin[0], m_RegionMax[0]);
-	m_maxBoxX = CALC_RANGE(vecOrigin.x + flDist, m_RegionMin[0], m_RegionMax[0]);
-	m_minBoxY = CALC_RANGE(vecOrigin.y - flDist, m_RegionMin[1], m_RegionMax[1]);
-	m_maxBoxY = CALC_RANGE(vecOrigin.y + flDist, m_RegionMin[1], m_RegionMax[1]);
-	m_minBoxZ = CALC_RANGE(vecOrigin.z - flDist, m_RegionMin[2], m_RegionMax[2]);
-	m_maxBoxZ = CALC_RANGE(vecOrigin.z + flDist, m_RegionMin[2], m_RegionMax[2])
-    CalcBounds(m_minX, m_maxX, CALC_RANGE(vecOrigin.x, m_RegionMin[0], m_RegionMax[0]), m_pNodes[m_iNearest].m_Region[0]);
-    CalcBounds(m_minY, m_maxY, CALC_RANGE(vecOrigin.y, m_RegionMin[1], m_RegionMax[1]), m_pNodes[m_iNearest].m_Region[1]);
-    CalcBounds(m_minZ, m_maxZ, CALC_RANGE(vecOrigin.z, m_RegionMin[2], m_RegionMax[2]), m_pNodes[m_iNearest].m_Region[2]);
-#endif
-
-    int halfX = (m_minX+m_maxX)/2;
-    int halfY = (m_minY+m_maxY)/2;
-    int halfZ = (m_minZ+m_maxZ)/2;
-
-    int j;
+	s_NearestHeap.cItems = 0;
+	HeapInsert( &s_NearestHeap, -1, CellDistance( &s_pTreeCells[0], vecOrigin ), 0.0f );
 
-    for (i = halfX; i >= m_minX; i--)
-    {
-        for (j = m_RangeStart[0][i]; j <= m_RangeEnd[0][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[0]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgY = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[1];
-			if (rgY > m_maxBoxY) break;
-            if (rgY < m_minBoxY) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[2];
-            if (rgZ < m_minBoxZ) continue;
-            if (rgZ > m_maxBoxZ) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[0]);
-        }
-    }
-
-    for (i = max(m_minY,halfY+1); i <= m_maxY; i++)
-    {
-        for (j = m_RangeStart[1][i]; j <= m_RangeEnd[1][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[1]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[2];
-            if (rgZ > m_maxBoxZ) break;
-            if (rgZ < m_minBoxZ) continue;
-			int rgX = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[0];
-            if (rgX < m_minBoxX) continue;
-            if (rgX > m_maxBoxX) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[1]);
-        }
-    }
-
-    for (i = min(m_maxZ,halfZ); i >= m_minZ; i--)
-    {
-        for (j = m_RangeStart[2][i]; j <= m_RangeEnd[2][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[2]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgX = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[0];
-            if (rgX > m_maxBoxX) break;
-            if (rgX < m_minBoxX) continue;
-			int rgY = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[1];
-            if (rgY < m_minBoxY) continue;
-			if (rgY > m_maxBoxY) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[2]);
-        }
-    }
-
-    for (i = max(m_minX,halfX+1); i <= m_maxX; i++)
-    {
-        for (j = m_RangeStart[0][i]; j <= m_RangeEnd[0][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[0]].m_afNodeInfo & afNodeTypes)) continue;
+	while ( s_NearestHeap.cItems )
+	{
+		OPEN_NODE Item = HeapRemove( &s_NearestHeap );
 
-			int rgY = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[1];
-			if (rgY > m_maxBoxY) break;
-            if (rgY < m_minBoxY) continue;
+		// nothing left is nearer than the seed
+		if ( Item.Priority >= m_flShortest )
+			break;
 
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[0]].m_Region[2];
-            if (rgZ < m_minBoxZ) continue;
-            if (rgZ > m_maxBoxZ) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[0]);
-        }
-    }
+		if ( Item.Id >= 0 )
+		{
+			// make sure that vecOrigin can trace to this node!
+			UTIL_TraceLine ( vecOrigin, m_pNodes[ Item.Id ].m_vecOriginPeek, ignore_monsters, 0, &tr );
 
-    for (i = min(m_maxY,halfY); i >= m_minY; i--)
-    {
-        for (j = m_RangeStart[1][i]; j <= m_RangeEnd[1][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[1]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgZ = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[2];
-            if (rgZ > m_maxBoxZ) break;
-            if (rgZ < m_minBoxZ) continue;
-			int rgX = m_pNodes[m_di[j].m_SortedBy[1]].m_Region[0];
-            if (rgX < m_minBoxX) continue;
-            if (rgX > m_maxBoxX) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[1]);
-        }
-    }
+			if ( tr.flFraction == 1.0 )
+			{
+				m_iNearest = Item.Id;
+				m_flShortest = Item.Priority;
+				break;
+			}
+			continue;
+		}
 
-    for (i = max(m_minZ,halfZ+1); i <= m_maxZ; i++)
-    {
-        for (j = m_RangeStart[2][i]; j <= m_RangeEnd[2][i]; j++)
-        {
-			if (!(m_pNodes[m_di[j].m_SortedBy[2]].m_afNodeInfo & afNodeTypes)) continue;
-
-			int rgX = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[0];
-            if (rgX > m_maxBoxX) break;
-            if (rgX < m_minBoxX) continue;
-			int rgY = m_pNodes[m_di[j].m_SortedBy[2]].m_Region[1];
-            if (rgY < m_minBoxY) continue;
-			if (rgY > m_maxBoxY) continue;
-            CheckNode(vecOrigin, m_di[j].m_SortedBy[2]);
-        }
-    }
+		NODETREE_CELL *pCell = &s_pTreeCells[-Item.Id - 1];
 
-#if 0
-	// Verify our answers.
-	//
-	int iNearestCheck = -1;
-	m_flShortest = 8192;// find nodes within this radius
+		if ( pCell->iChildren[0] != -1 )
+		{
+			for ( int i = 0; i < 2; i++ )
+			{
+				NODETREE_CELL *pChild = &s_pTreeCells[pCell->iChildren[i]];
 
-	for ( i = 0 ; i < m_cNodes ; i++ )
-	{
-		float flDist = ( vecOrigin - m_pNodes[ i ].m_vecOriginPeek ).Length();
+				if ( pChild->afNodeInfo & afNodeTypes )
+					HeapInsert( &s_NearestHeap, -pCell->iChildren[i] - 1, CellDistance( pChild, vecOrigin ), 0.0f );
+			}
+			continue;
+		}
 
-		if ( flDist < m_flShortest )
+		for ( int i = pCell->iFirstNode; i < pCell->iFirstNode + pCell->cNodes; i++ )
 		{
-			// make sure that vecOrigin can trace to this node!
-			UTIL_TraceLine ( vecOrigin, m_pNodes[ i ].m_vecOriginPeek, ignore_monsters, 0, &tr );
+			int iNode = s_pTreeNodes[i];
 
-			if ( tr.flFraction == 1.0 )
-			{
-				iNearestCheck = i;
-				m_flShortest = flDist;
-			}
+			if ( m_pNodes[ iNode ].m_afNodeInfo & afNodeTypes )
+				HeapInsert( &s_NearestHeap, iNode, ( vecOrigin - m_pNodes[ iNode ].m_vecOriginPeek ).Length(), 0.0f );
 		}
 	}
 
-	if (iNearestCheck != m_iNearest)
-	{
-		ALERT( at_aiconsole, "NOT closest %d(%f,%f,%f) %d(%f,%f,%f).\n",
-			iNearestCheck,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.x,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.y,
-			m_pNodes[iNearestCheck].m_vecOriginPeek.z,
-			m_iNearest,
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.x),
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.y),
-			(m_iNearest == -1?0.0:m_pNodes[m_iNearest].m_vecOriginPeek.z));
-	}
-	if (m_iNearest == -1)
-	{
-		ALERT(at_aiconsole, "All that work for nothing.\n");
-	}
-#endif
 	m_Cache[iHash].v = vecOrigin;
 	m_Cache[iHash].n = m_iNearest;
 	return m_iNearest;
@@ -1126,6 +1349,63 @@ void CGraph :: ShowNodeConnections ( int iNode )
 	}
 }
 
+//=========================================================
+// Link traces. Every pair of nodes is checked from both ends
+// and a blocked pair also traces back from the other end, so
+// the results are kept for when the other end is linked.
+//=========================================================
+#define LINKTRACE_DONE		1
+#define LINKTRACE_STARTSOLID	2
+#define LINKTRACE_CLEAR		4
+#define LINKTRACE_HIT		8
+#define LINKTRACE_ENTSHIFT	4
+
+static int	*s_pLinkTraces = NULL;	// m_cNodes * m_cNodes of LINKTRACE_* and the hit entity
+static int	s_cLinkTraceNodes = 0;
+
+static void FreeLinkTraces( void )
+{
+	free( s_pLinkTraces );
+	s_pLinkTraces = NULL;
+	s_cLinkTraceNodes = 0;
+}
+
+static int LinkTrace( CNode *pNodes, int iSrc, int iDest, edict_t **ppHit )
+{
+	int *pTrace = s_pLinkTraces ? &s_pLinkTraces[iSrc * s_cLinkTraceNodes + iDest] : NULL;
+	TraceResult tr;
+	int iResult;
+
+	if ( pTrace && *pTrace )
+	{
+		iResult = *pTrace;
+		*ppHit = ( iResult & LINKTRACE_HIT ) ? INDEXENT( iResult >> LINKTRACE_ENTSHIFT ) : NULL;
+		return iResult;
+	}
+
+	tr.pHit = NULL;// clear every time so we don't get stuck with last trace's hit ent
+
+	UTIL_TraceLine ( pNodes[ iSrc ].m_vecOrigin,
+					 pNodes[ iDest ].m_vecOrigin,
+					 ignore_monsters,
+					 g_pBodyQueueHead,//!!!HACKHACK no real ent to supply here, using a global we don't care about
+					 &tr );
+
+	iResult = LINKTRACE_DONE;
+	if ( tr.fStartSolid )
+		iResult |= LINKTRACE_STARTSOLID;
+	if ( tr.flFraction == 1.0 )
+		iResult |= LINKTRACE_CLEAR;
+	if ( tr.pHit )
+		iResult |= LINKTRACE_HIT | ( ENTINDEX( tr.pHit ) << LINKTRACE_ENTSHIFT );
+
+	if ( pTrace )
+		*pTrace = iResult;
+
+	*ppHit = tr.pHit;
+	return iResult;
+}
+
 //=========================================================
 // CGraph - LinkVisibleNodes - the first, most basic
 // function of node graph creation, this connects every
@@ -1143,6 +1423,7 @@ int CGraph :: LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode )
 	edict_t		*pTraceEnt;
 	int			cTotalLinks, cLinksThisNode, cMaxInitialLinks;
 	TraceResult	tr;
+	int			iTrace;
 	
 	// !!!BUGBUG - this function returns 0 if there is a problem in the middle of connecting the graph
 	// it also returns 0 if none of the nodes in a level can see each other. piBadNode is ALWAYS read
@@ -1171,6 +1452,10 @@ int CGraph :: LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode )
 	}
 
 	cTotalLinks = 0;// start with no connections
+
+	// without the trace cache every trace is just done twice
+	s_pLinkTraces = (int *)calloc( m_cNodes * m_cNodes, sizeof( int ));
+	s_cLinkTraceNodes = m_cNodes;
 	
 	// to keep track of the maximum number of initial links any node had so far.
 	// this lets us keep an eye on MAX_NODE_INITIAL_LINKS to ensure that we are
@@ -1218,29 +1503,19 @@ int CGraph :: LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode )
 			}
 #endif
 
-			tr.pHit = NULL;// clear every time so we don't get stuck with last trace's hit ent
 			pTraceEnt = 0;
 
-			UTIL_TraceLine ( m_pNodes[ i ].m_vecOrigin,
-							 m_pNodes[ j ].m_vecOrigin,
-							 ignore_monsters,
-							 g_pBodyQueueHead,//!!!HACKHACK no real ent to supply here, using a global we don't care about
-							 &tr );
-			
+			iTrace = LinkTrace( m_pNodes, i, j, &tr.pHit );
 			
-			if ( tr.fStartSolid )
+			if ( iTrace & LINKTRACE_STARTSOLID )
 				continue;
 
-			if ( tr.flFraction != 1.0 )
+			if ( !( iTrace & LINKTRACE_CLEAR ))
 			{// trace hit a brush ent, trace backwards to make sure that this ent is the only thing in the way.
 				
 				pTraceEnt = tr.pHit;// store the ent that the trace hit, for comparison
 	
-				UTIL_TraceLine ( m_pNodes[ j ].m_vecOrigin,
-								 m_pNodes[ i ].m_vecOrigin,
-								 ignore_monsters,
-								 g_pBodyQueueHead,//!!!HACKHACK no real ent to supply here, using a global we don't care about
-								 &tr );
+				LinkTrace( m_pNodes, j, i, &tr.pHit );
 
 				
 // there is a solid_bsp ent in the way of these two nodes, so we must record several things about in order to keep
@@ -1292,12 +1567,14 @@ int CGraph :: LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode )
 				ALERT ( at_aiconsole, "**LinkVisibleNodes:\nNode %d has NodeLinks > MAX_NODE_INITIAL_LINKS", i );
 				fprintf ( file, "** NODE %d HAS NodeLinks > MAX_NODE_INITIAL_LINKS **\n", i );
 				*piBadNode = i;
+				FreeLinkTraces();
 				return	FALSE;
 			}
 			else if ( cTotalLinks > MAX_NODE_INITIAL_LINKS * m_cNodes )
 			{// this is paranoia
 				ALERT ( at_aiconsole, "**LinkVisibleNodes:\nTotalLinks > MAX_NODE_INITIAL_LINKS * NUMNODES" );
 				*piBadNode = i;
+				FreeLinkTraces();
 				return	FALSE;
 			}
 
@@ -1327,6 +1604,8 @@ int CGraph :: LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode )
 	fprintf ( file, "\n%4d Total Initial Connections - %4d Maximum connections for a single node.\n", cTotalLinks, cMaxInitialLinks );
 	fprintf ( file, "----------------------------------------------------------------------------\n\n\n" );
 
+	FreeLinkTraces();
+
 	return cTotalLinks;
 }
 
@@ -2595,6 +2874,8 @@ int CGraph :: FSetGraphPointers ( void )
 		}
 	}
 
+	BuildNodeTree();
+
 	// the pointers are now set.
 	m_fGraphPointersSet = TRUE;
 	return TRUE;
@@ -3079,11 +3360,33 @@ void CGraph :: ComputeStaticRoutingTables( void )
 
 				for (iFrom = 0; iFrom < m_cNodes; iFrom++)
 				{
+					// A single search from iFrom gives the shortest paths to all the
+					// nodes at once, so there is no need to search for every pair.
+					//
+					BOOL fSearched = FALSE;
+					BOOL fTree = FALSE;
+
 					for (int iTo = m_cNodes-1; iTo >= 0; iTo--)
 					{
 						if (Routes[FROM_TO(iFrom, iTo)] != -1) continue;
 
-						int cPathSize = FindShortestPath(pMyPath, iFrom, iTo, iHull, iCapMask);
+						if (!fSearched)
+						{
+							fTree = SearchPaths(iFrom, NO_NODE, iHull, iCapMask);
+							fSearched = TRUE;
+						}
+
+						int cPathSize = 0;
+
+						if (iFrom == iTo)
+						{
+							pMyPath[0] = pMyPath[1] = iFrom;
+							cPathSize = 2;
+						}
+						else if (fTree && s_pSearchGen[iTo] == s_iSearchGen)
+						{
+							cPathSize = CopyPath(pMyPath, iFrom, iTo);
+						}
 
 						// Use the computed path to update the routing table.
 						//
@@ -3331,13 +3634,14 @@ void CGraph :: ComputeStaticRoutingTables( void )
 	pRoute = 0;
 	pMyPath = 0;
 
-#if 0
-	TestRoutingTables();
-#endif
+	if ( g_verify_nodegraph.value )
+		TestRoutingTables();
 	m_fRoutingComplete = TRUE;
 }
 
-// Test those routing tables. Doesn't really work, yet.
+// Test those routing tables: every path from the tables must
+// be as long as the one found by the search. sv_verify_nodegraph
+// runs it after the tables were built.
 //
 void CGraph :: TestRoutingTables( void )
 {
@@ -3456,6 +3760,8 @@ void CGraph :: TestRoutingTables( void )
 		}
 	}
 
+	ALERT(at_aiconsole, "Routing tables are consistent.\n");
+
 EnoughSaid:
 
 	if (pMyPath) delete pMyPath;
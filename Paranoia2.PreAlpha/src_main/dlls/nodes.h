@@ -162,8 +162,13 @@ public:
 	int		LinkVisibleNodes ( CLink *pLinkPool, FILE *file, int *piBadNode );
 	int		RejectInlineLinks ( CLink *pLinkPool, FILE *file );
 	int		FindShortestPath ( int *piPath, int iStart, int iDest, int iHull, int afCapMask);
+	BOOL	SearchPaths ( int iStart, int iDest, int iHull, int afCapMask );
+	int		CopyPath ( int *piPath, int iStart, int iDest );
+	BOOL	AllocPathSearch ( void );
+	void	FreePathSearch ( void );
+	float	PathEstimate ( int iNode, int iDest );
 	int		FindNearestNode ( const Vector &vecOrigin, CBaseEntity *pEntity );
-	int		FindNearestNode ( const Vector &vecOrigin, int afNodeTypes );
+	int		FindNearestNode ( const Vector &vecOrigin, int afNodeTypes, int iSeed = -1 );
 	//int		FindNearestLink ( const Vector &vecTestPoint, int *piNearestLink, BOOL *pfAlongLine );
 	float	PathLength( int iStart, int iDest, int iHull, int afCapMask );
 	int		NextNodeInRoute( int iCurrentNode, int iDest, int iHull, int iCap );
@@ -181,7 +186,8 @@ public:
 	int		FLoadGraph(char *szMapName);
 	int		FSaveGraph(char *szMapName);
 	int		FSetGraphPointers(void);
-	void	CheckNode(Vector vecOrigin, int iNode);
+	BOOL	BuildNodeTree(void);
+	void	FreeNodeTree(void);
 
 	void    BuildRegionTables(void);
 	void    ComputeStaticRoutingTables(void);
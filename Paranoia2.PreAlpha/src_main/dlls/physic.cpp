@@ -58,12 +58,11 @@ void Physic_SweepTest( CBaseEntity *pTouch, const Vector &start, const Vector &m
 		return;
 	}
 
-	mmesh_t *pMesh = pTouch->m_BodyMesh.CheckMesh( pTouch->pev->origin, pTouch->pev->angles );
-	areanode_t *pHeadNode = pTouch->m_BodyMesh.GetHeadNode();
+	CMeshDesc *pMeshDesc = pTouch->m_BodyMesh.CheckMesh( pTouch );
 
-	if( !pMesh )
+	if( !pMeshDesc )
 	{
-		// update cache or build from scratch
+		// find the shared mesh or build from scratch
 		if( !pTouch->m_BodyMesh.StudioConstructMesh( pTouch ))
 		{
 			// failed to build mesh for some reasons, so skip them
@@ -71,19 +70,29 @@ void Physic_SweepTest( CBaseEntity *pTouch, const Vector &start, const Vector &m
 			return;
 		}
 
-		// NOTE: don't care about validity this pointer
-		// just trace failed if it's happens
-		pMesh = pTouch->m_BodyMesh.GetMesh();
-		pHeadNode = pTouch->m_BodyMesh.GetHeadNode();
+		pMeshDesc = pTouch->m_BodyMesh.CheckMesh( pTouch );
 	}
 
+	// mesh is stored in model space, move the trace into it
+	matrix3x4	transform( pTouch->pev->origin, pTouch->pev->angles );
+	Vector	localStart = transform.VectorITransform( start );
+	Vector	localEnd = transform.VectorITransform( end );
 	TraceMesh	trm;	// a name like Doom3 :-)
 
-	trm.SetTraceMesh( pMesh, pHeadNode );
-	trm.SetupTrace( start, mins, maxs, end, tr );
+	trm.SetTraceMesh( pMeshDesc->GetMesh() );
+	trm.SetupTrace( localStart, mins, maxs, localEnd, tr );
 
-	if( trm.DoTrace())
+	bool hit = trm.DoTrace();
+
+	// and the result back into world space
+	if( tr->fraction == 1.0f ) tr->endpos = end;
+	else VectorLerp( start, tr->fraction, end, tr->endpos );
+
+	if( hit )
 	{
+		tr->plane.normal = transform.VectorRotate( tr->plane.normal );
+		tr->plane.dist += DotProduct( tr->plane.normal, pTouch->pev->origin );
+
 		if( tr->fraction < 1.0f || tr->startsolid )
 			tr->ent = pTouch->edict();
 	}
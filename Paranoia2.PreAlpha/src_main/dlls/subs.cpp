@@ -112,16 +112,7 @@ void CBaseEntity::UpdateOnRemove( void )
 	}
 
 	//LRC - remove this from the AssistList.
-	for (pTemp = g_pWorld; pTemp->m_pAssistLink != NULL; pTemp = pTemp->m_pAssistLink)
-	{
-		if (this == pTemp->m_pAssistLink)
-		{
-//			ALERT(at_console,"REMOVE: %s removed from the Assist List.\n", STRING(pev->classname));
-			pTemp->m_pAssistLink = this->m_pAssistLink;
-			this->m_pAssistLink = NULL;
-			break;
-		}
-	}
+	UTIL_RemoveFromAssistList( this );
 
 	//LRC
 	if (m_pMoveWith)
@@ -81,7 +81,7 @@ void TraceMesh :: ClipBoxToFacet( mfacet_t *facet )
 
 	for( int i = 0; i < facet->numplanes; i++ )
 	{
-		p = &mesh->planes[facet->indices[i]];
+		p = &facet->planes[i];
 
 		// push the plane out apropriately for mins/maxs
 		if( p->type < 3 )
@@ -195,7 +195,7 @@ void TraceMesh :: TestBoxInFacet( mfacet_t *facet )
 
 	for( int i = 0; i < facet->numplanes; i++ )
 	{
-		p = &mesh->planes[facet->indices[i]];
+		p = &facet->planes[i];
 
 		// push the plane out apropriately for mins/maxs
 		// if completely in front of face, no intersection
@@ -253,18 +253,10 @@ void TraceMesh :: TestBoxInFacet( mfacet_t *facet )
 	trace->allsolid = true;
 }
 
-void TraceMesh :: ClipToLinks( areanode_t *node )
+void TraceMesh :: ClipToFacets( mfacet_t *facet, int numfacets )
 {
-	link_t	*l, *next;
-	mfacet_t	*facet;
-
-	// touch linked edicts
-	for( l = node->solid_edicts.next; l != &node->solid_edicts; l = next )
+	for( int i = 0; i < numfacets; i++, facet++ )
 	{
-		next = l->next;
-
-		facet = FACET_FROM_AREA( l );
-
 		if( !BoundsIntersect( m_vecAbsMins, m_vecAbsMaxs, facet->mins, facet->maxs ))
 			continue;
 
@@ -275,42 +267,48 @@ void TraceMesh :: ClipToLinks( areanode_t *node )
 			TestBoxInFacet( facet );
 		else ClipBoxToFacet( facet );
 	}
-	
-	// recurse down both sides
-	if( node->axis == -1 ) return;
-
-	if( m_vecAbsMaxs[node->axis] > node->dist )
-		ClipToLinks( node->children[0] );
-	if( m_vecAbsMins[node->axis] < node->dist )
-		ClipToLinks( node->children[1] );
 }
 
-bool TraceMesh :: DoTrace( void )
+void TraceMesh :: ClipToTree( void )
 {
-	if( !mesh || !BoundsIntersect( mesh->mins, mesh->maxs, m_vecAbsMins, m_vecAbsMaxs ))
-		return false; // invalid mesh or no intersection
+	mbvhnode_t	*stack[BVH_MAX_DEPTH+1];
+	mbvhnode_t	*node;
+	int		depth = 0;
 
-	checkcount = 0;
+	stack[depth++] = mesh->nodes;
 
-	if( areanodes )
+	while( depth > 0 )
 	{
-		ClipToLinks( areanodes );
-	}
-	else
-	{
-		mfacet_t *facet = mesh->facets;
-		for( int i = 0; i < mesh->numfacets; i++, facet++ )
-		{
-			if( bIsTestPosition )
-				TestBoxInFacet( facet );
-			else ClipBoxToFacet( facet );
+		node = stack[--depth];
 
-			if( !m_flRealFraction )
-				break;
+		if( !BoundsIntersect( m_vecAbsMins, m_vecAbsMaxs, node->mins, node->maxs ))
+			continue;
+
+		if( node->numfacets )
+		{
+			ClipToFacets( mesh->facets + node->firstfacet, node->numfacets );
+			if( !m_flRealFraction ) return;
+			continue;
 		}
+
+		// children are always allocated in pairs
+		stack[depth++] = mesh->nodes + node->firstfacet + 1;
+		stack[depth++] = mesh->nodes + node->firstfacet;
 	}
+}
+
+bool TraceMesh :: DoTrace( void )
+{
+	if( !mesh || !BoundsIntersect( mesh->mins, mesh->maxs, m_vecAbsMins, m_vecAbsMaxs ))
+		return false; // invalid mesh or no intersection
+
+	checkcount = 0;
+
+	if( mesh->numnodes )
+		ClipToTree();
+	else ClipToFacets( mesh->facets, mesh->numfacets );
 
-//	ALERT( at_aiconsole, "total %i checks for %s\n", checkcount, areanodes ? "tree" : "brute force" );
+//	ALERT( at_aiconsole, "total %i checks for %s\n", checkcount, mesh->numnodes ? "tree" : "brute force" );
 
 	trace->fraction = bound( 0.0f, trace->fraction, 1.0f );
 	if( trace->fraction == 1.0f ) trace->endpos = m_vecEnd;
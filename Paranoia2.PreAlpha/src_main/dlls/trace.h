@@ -30,7 +30,6 @@ private:
 	Vector		m_vecAbsMins, m_vecAbsMaxs;
 	float		m_flRealFraction;
 	bool		bIsTestPosition;
-	areanode_t	*areanodes;	// AABB for static meshes
 	mmesh_t		*mesh;		// mesh to trace
 	trace_t  		*trace;		// output
 	int		checkcount;	// debug
@@ -39,11 +38,12 @@ public:
 	~TraceMesh() {}
 
 	// trace stuff
-	void SetTraceMesh( mmesh_t *cached_mesh, areanode_t *tree ) { mesh = cached_mesh; areanodes = tree; }
+	void SetTraceMesh( mmesh_t *cached_mesh ) { mesh = cached_mesh; }
 	void SetupTrace( const Vector &start, const Vector &mins, const Vector &maxs, const Vector &end, trace_t *trace ); 
 	void ClipBoxToFacet( mfacet_t	*facet );
 	void TestBoxInFacet( mfacet_t	*facet );
-	void ClipToLinks( areanode_t *node );
+	void ClipToFacets( mfacet_t *facet, int numfacets );
+	void ClipToTree( void );
 	bool DoTrace( void );
 };
 
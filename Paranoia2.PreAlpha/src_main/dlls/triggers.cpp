@@ -881,6 +881,7 @@ CMultiManager *CMultiManager::Clone( void )
 	pMulti->pev->spawnflags |= SF_MULTIMAN_CLONE;
 	pMulti->m_cTargets = m_cTargets;
 	if (m_iszThreadName) pMulti->pev->targetname = m_iszThreadName; //LRC
+	UTIL_RelinkEntityNames( pEdict );
 	pMulti->m_triggerType = m_triggerType; //LRC
 	pMulti->m_iMode = m_iMode; //LRC
 	pMulti->m_flWait = m_flWait; //LRC
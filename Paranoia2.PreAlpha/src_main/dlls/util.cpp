@@ -436,19 +436,213 @@ void UTIL_MoveToOrigin( edict_t *pent, const Vector &vecGoal, float flDist, int
 }
 
 
+//=========================================================
+// Entity grid - coarse 2D grid of the edicts for the area
+// queries below. Each edict sits in the single cell of its
+// absmin, edicts bigger than a cell go to the separate list.
+// The engine calls pfnSetAbsBox on every link, so the grid
+// is relinked from DispatchObjectCollsionBox.
+//=========================================================
+#define ENTGRID_CELL_SIZE	512
+#define ENTGRID_HASH_SIZE	1024			// must be power of two
+#define ENTGRID_LARGE	ENTGRID_HASH_SIZE		// bucket of the big edicts
+#define ENTGRID_MAX_CELLS	256			// bigger queries just scan all the edicts
+
+typedef struct
+{
+	int	next, prev;		// index-based bucket list, -1 terminates
+	int	bucket;			// -1 when unlinked
+	int	cellx, celly;
+} entgridlink_t;
+
+static entgridlink_t	*g_pEntGrid = NULL;
+static int		*g_pEntGridResults = NULL;
+static int		g_iEntGridSize = 0;
+static int		g_iEntGridHeads[ENTGRID_HASH_SIZE+1];
+
+static int EntGrid_Hash( int cellx, int celly )
+{
+	return ((unsigned int)cellx * 73856093U ^ (unsigned int)celly * 19349663U) & (ENTGRID_HASH_SIZE - 1);
+}
+
+static int EntGrid_Cell( float coord )
+{
+	return (int)floor( coord / ENTGRID_CELL_SIZE );
+}
+
+static BOOL EntGrid_Init( void )
+{
+	int i;
+
+	if( g_pEntGrid && g_iEntGridSize == gpGlobals->maxEntities )
+		return TRUE;
+
+	UTIL_ClearEntityGrid();
+
+	if( gpGlobals->maxEntities <= 0 )
+		return FALSE;
+
+	g_iEntGridSize = gpGlobals->maxEntities;
+	g_pEntGrid = (entgridlink_t *)malloc( sizeof( entgridlink_t ) * g_iEntGridSize );
+	g_pEntGridResults = (int *)malloc( sizeof( int ) * g_iEntGridSize );
+
+	for( i = 0; i < g_iEntGridSize; i++ )
+		g_pEntGrid[i].bucket = -1;
+
+	for( i = 0; i <= ENTGRID_HASH_SIZE; i++ )
+		g_iEntGridHeads[i] = -1;
+
+	return TRUE;
+}
+
+void UTIL_ClearEntityGrid( void )
+{
+	free( g_pEntGrid );
+	free( g_pEntGridResults );
+	g_pEntGrid = NULL;
+	g_pEntGridResults = NULL;
+	g_iEntGridSize = 0;
+}
+
+void UTIL_UnlinkEntityGrid( edict_t *pent )
+{
+	entgridlink_t *link;
+	int index;
+
+	if( !g_pEntGrid )
+		return;
+
+	index = ENTINDEX( pent );
+	if( index <= 0 || index >= g_iEntGridSize )
+		return;
+
+	link = &g_pEntGrid[index];
+	if( link->bucket == -1 )
+		return;
+
+	if( link->prev != -1 )
+		g_pEntGrid[link->prev].next = link->next;
+	else g_iEntGridHeads[link->bucket] = link->next;
+
+	if( link->next != -1 )
+		g_pEntGrid[link->next].prev = link->prev;
+
+	link->bucket = -1;
+}
+
+void UTIL_RelinkEntityGrid( edict_t *pent )
+{
+	entgridlink_t *link;
+	int index, bucket;
+	int cellx, celly;
+
+	if( !EntGrid_Init( ))
+		return;
+
+	index = ENTINDEX( pent );
+	if( index <= 0 || index >= g_iEntGridSize )
+		return; // world is never returned by the queries
+
+	if( pent->v.absmax.x - pent->v.absmin.x >= ENTGRID_CELL_SIZE || pent->v.absmax.y - pent->v.absmin.y >= ENTGRID_CELL_SIZE )
+	{
+		bucket = ENTGRID_LARGE;
+		cellx = celly = 0;
+	}
+	else
+	{
+		cellx = EntGrid_Cell( pent->v.absmin.x );
+		celly = EntGrid_Cell( pent->v.absmin.y );
+		bucket = EntGrid_Hash( cellx, celly );
+	}
+
+	link = &g_pEntGrid[index];
+	if( link->bucket == bucket && link->cellx == cellx && link->celly == celly )
+		return; // still in the same cell
+
+	UTIL_UnlinkEntityGrid( pent );
+
+	link->bucket = bucket;
+	link->cellx = cellx;
+	link->celly = celly;
+	link->prev = -1;
+	link->next = g_iEntGridHeads[bucket];
+	if( link->next != -1 )
+		g_pEntGrid[link->next].prev = index;
+	g_iEntGridHeads[bucket] = index;
+}
+
+static int EntGrid_CompareIndex( const void *a, const void *b )
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+// collect edicts which may touch the box, in the edict order
+static int EntGrid_Query( const Vector &mins, const Vector &maxs, int **results )
+{
+	int minx, miny, maxx, maxy;
+	int x, y, i, count = 0;
+
+	if( !EntGrid_Init( ))
+		return 0;
+
+	*results = g_pEntGridResults;
+
+	// an edict of cell N may reach into the cell N+1
+	minx = EntGrid_Cell( mins.x ) - 1;
+	miny = EntGrid_Cell( mins.y ) - 1;
+	maxx = EntGrid_Cell( maxs.x );
+	maxy = EntGrid_Cell( maxs.y );
+
+	if(( maxx - minx + 1 ) * ( maxy - miny + 1 ) > ENTGRID_MAX_CELLS )
+	{
+		// not worth it, take them all
+		for( i = 1; i < g_iEntGridSize; i++ )
+			g_pEntGridResults[count++] = i;
+		return count;
+	}
+
+	for( x = minx; x <= maxx; x++ )
+	{
+		for( y = miny; y <= maxy; y++ )
+		{
+			for( i = g_iEntGridHeads[EntGrid_Hash( x, y )]; i != -1; i = g_pEntGrid[i].next )
+			{
+				// other cells may share this bucket
+				if( g_pEntGrid[i].cellx == x && g_pEntGrid[i].celly == y )
+					g_pEntGridResults[count++] = i;
+			}
+		}
+	}
+
+	for( i = g_iEntGridHeads[ENTGRID_LARGE]; i != -1; i = g_pEntGrid[i].next )
+		g_pEntGridResults[count++] = i;
+
+	// callers stop at listMax, so keep the same order as full scan
+	qsort( g_pEntGridResults, count, sizeof( int ), EntGrid_CompareIndex );
+
+	return count;
+}
+
 int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, const Vector &maxs, int flagMask )
 {
-	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
+	edict_t		*pEdicts = g_engfuncs.pfnPEntityOfEntIndex( 0 );
+	edict_t		*pEdict;
 	CBaseEntity *pEntity;
+	int			*pCandidates;
+	int			numCandidates;
 	int			count;
 
 	count = 0;
 
-	if ( !pEdict )
+	if ( !pEdicts )
 		return count;
 
-	for ( int i = 1; i < gpGlobals->maxEntities; i++, pEdict++ )
+	numCandidates = EntGrid_Query( mins, maxs, &pCandidates );
+
+	for ( int i = 0; i < numCandidates; i++ )
 	{
+		pEdict = pEdicts + pCandidates[i];
+
 		if ( pEdict->free )	// Not in use
 			continue;
 		
@@ -480,19 +674,26 @@ int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, co
 
 int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &center, float radius )
 {
-	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
+	edict_t		*pEdicts = g_engfuncs.pfnPEntityOfEntIndex( 0 );
+	edict_t		*pEdict;
 	CBaseEntity *pEntity;
+	int			*pCandidates;
+	int			numCandidates;
 	int			count;
 	float		distance, delta;
 
 	count = 0;
 	float radiusSquared = radius * radius;
 
-	if ( !pEdict )
+	if ( !pEdicts )
 		return count;
 
-	for ( int i = 1; i < gpGlobals->maxEntities; i++, pEdict++ )
+	numCandidates = EntGrid_Query( center - Vector( radius, radius, radius ), center + Vector( radius, radius, radius ), &pCandidates );
+
+	for ( int i = 0; i < numCandidates; i++ )
 	{
+		pEdict = pEdicts + pCandidates[i];
+
 		if ( pEdict->free )	// Not in use
 			continue;
 		
@@ -557,20 +758,264 @@ CBaseEntity *UTIL_FindEntityInSphere( CBaseEntity *pStartEntity, const Vector &v
 }
 
 
+//=========================================================
+// Entity names - targetname and classname lists for the
+// UTIL_FindEntityBy* lookups. Every hash chain is kept sorted
+// by the edict index so the lookups return entities in the
+// same order as FIND_ENTITY_BY_STRING does. The names are
+// relinked on spawn, restore, every engine link and by the
+// code that renames an existing entity, UTIL_SyncEntityNames
+// catches up the rest once per frame. The chain entries are
+// always checked against the real name on lookup.
+//=========================================================
+#define ENTNAMES_HASH_SIZE	4096			// must be power of two
+
+typedef struct
+{
+	int	next, prev;		// index-based sorted chain, -1 terminates
+	int	bucket;			// -1 when unlinked
+	string_t	name;			// the name it was linked with
+} entnamelink_t;
+
+typedef struct
+{
+	const char	*keyword;
+	int		fieldofs;			// offset of the string_t in entvars_t
+	entnamelink_t	*links;
+	int		heads[ENTNAMES_HASH_SIZE];
+} entnames_t;
+
+#define ENTNAMES_FIELD( names, pent )	(*(string_t *)((byte *)&(pent)->v + (names)->fieldofs))
+
+static entnames_t	g_EntTargetnames = { "targetname", offsetof( entvars_t, targetname ) };
+static entnames_t	g_EntClassnames = { "classname", offsetof( entvars_t, classname ) };
+static int	g_iEntNamesSize = 0;
+
+static int EntNames_Hash( const char *name )
+{
+	unsigned int hash = 0;
+
+	while( *name )
+		hash = ((hash >> 4) | (hash << 28)) ^ (unsigned char)*name++;
+
+	return hash & (ENTNAMES_HASH_SIZE - 1);
+}
+
+static void EntNames_Unlink( entnames_t *names, int index )
+{
+	entnamelink_t *link = &names->links[index];
+
+	if( link->bucket == -1 )
+		return;
+
+	if( link->prev != -1 )
+		names->links[link->prev].next = link->next;
+	else names->heads[link->bucket] = link->next;
+
+	if( link->next != -1 )
+		names->links[link->next].prev = link->prev;
+
+	link->bucket = -1;
+	link->name = 0;
+}
+
+static void EntNames_Link( entnames_t *names, int index, string_t name )
+{
+	entnamelink_t *link = &names->links[index];
+	int prev, next;
+
+	if( link->bucket != -1 && link->name == name )
+		return; // not changed
+
+	EntNames_Unlink( names, index );
+
+	if( FStringNull( name ))
+		return;
+
+	link->bucket = EntNames_Hash( STRING( name ));
+	link->name = name;
+
+	// keep the chain in edict order
+	for( prev = -1, next = names->heads[link->bucket]; next != -1 && next < index; next = names->links[next].next )
+		prev = next;
+
+	link->prev = prev;
+	link->next = next;
+
+	if( prev != -1 )
+		names->links[prev].next = index;
+	else names->heads[link->bucket] = index;
+
+	if( next != -1 )
+		names->links[next].prev = index;
+}
+
+static void EntNames_Alloc( entnames_t *names )
+{
+	int i;
+
+	names->links = (entnamelink_t *)malloc( sizeof( entnamelink_t ) * g_iEntNamesSize );
+
+	for( i = 0; i < g_iEntNamesSize; i++ )
+		names->links[i].bucket = -1;
+
+	for( i = 0; i < ENTNAMES_HASH_SIZE; i++ )
+		names->heads[i] = -1;
+}
+
+static BOOL EntNames_Init( void )
+{
+	if( g_EntTargetnames.links && g_iEntNamesSize == gpGlobals->maxEntities )
+		return TRUE;
+
+	UTIL_ClearEntityNames();
+
+	if( gpGlobals->maxEntities <= 0 )
+		return FALSE;
+
+	g_iEntNamesSize = gpGlobals->maxEntities;
+	EntNames_Alloc( &g_EntTargetnames );
+	EntNames_Alloc( &g_EntClassnames );
+
+	// pick up everything what was spawned before
+	UTIL_SyncEntityNames();
+
+	return TRUE;
+}
+
+void UTIL_ClearEntityNames( void )
+{
+	free( g_EntTargetnames.links );
+	free( g_EntClassnames.links );
+	g_EntTargetnames.links = NULL;
+	g_EntClassnames.links = NULL;
+	g_iEntNamesSize = 0;
+}
+
+void UTIL_RelinkEntityNames( edict_t *pent )
+{
+	int index;
+
+	if( !EntNames_Init( ))
+		return;
+
+	index = ENTINDEX( pent );
+	if( index < 0 || index >= g_iEntNamesSize )
+		return;
+
+	if( pent->free )
+	{
+		UTIL_UnlinkEntityNames( pent );
+		return;
+	}
+
+	EntNames_Link( &g_EntTargetnames, index, ENTNAMES_FIELD( &g_EntTargetnames, pent ));
+	EntNames_Link( &g_EntClassnames, index, ENTNAMES_FIELD( &g_EntClassnames, pent ));
+}
+
+void UTIL_UnlinkEntityNames( edict_t *pent )
+{
+	int index;
+
+	if( !g_EntTargetnames.links )
+		return;
+
+	index = ENTINDEX( pent );
+	if( index < 0 || index >= g_iEntNamesSize )
+		return;
+
+	EntNames_Unlink( &g_EntTargetnames, index );
+	EntNames_Unlink( &g_EntClassnames, index );
+}
+
+// catch up the names which was changed behind our back. Just a string_t compare per edict
+void UTIL_SyncEntityNames( void )
+{
+	edict_t	*pEdicts;
+	edict_t	*pEdict;
+
+	if( !g_EntTargetnames.links )
+		return;
+
+	pEdicts = g_engfuncs.pfnPEntityOfEntIndex( 0 );
+	if( !pEdicts )
+		return;
+
+	for( int i = 0; i < g_iEntNamesSize; i++ )
+	{
+		pEdict = pEdicts + i;
+
+		if( pEdict->free )
+		{
+			EntNames_Unlink( &g_EntTargetnames, i );
+			EntNames_Unlink( &g_EntClassnames, i );
+			continue;
+		}
+
+		EntNames_Link( &g_EntTargetnames, i, ENTNAMES_FIELD( &g_EntTargetnames, pEdict ));
+		EntNames_Link( &g_EntClassnames, i, ENTNAMES_FIELD( &g_EntClassnames, pEdict ));
+	}
+}
+
+static edict_t *EntNames_Find( entnames_t *names, edict_t *pentStart, const char *szValue )
+{
+	edict_t	*pEdicts = g_engfuncs.pfnPEntityOfEntIndex( 0 );
+	edict_t	*pEdict;
+	int	start, i;
+
+	start = pentStart ? ENTINDEX( pentStart ) : -1;
+
+	// continue from the start entity when it's in our chain
+	if( start >= 0 && start < g_iEntNamesSize && names->links[start].bucket != -1 && !strcmp( STRING( names->links[start].name ), szValue ))
+		i = names->links[start].next;
+	else i = names->heads[EntNames_Hash( szValue )];
+
+	for( ; i != -1; i = names->links[i].next )
+	{
+		if( i <= start )
+			continue;
+
+		pEdict = pEdicts + i;
+
+		if( pEdict->free )
+			continue;
+
+		// entry may be outdated or just share the chain
+		if( !strcmp( STRING( ENTNAMES_FIELD( names, pEdict )), szValue ))
+			return pEdict;
+	}
+
+	return NULL;
+}
+
 CBaseEntity *UTIL_FindEntityByString( CBaseEntity *pStartEntity, const char *szKeyword, const char *szValue )
 {
 	edict_t	*pentEntity;
 	CBaseEntity *pEntity;
 
+	entnames_t *names = NULL;
+
 	if (pStartEntity)
 		pentEntity = pStartEntity->edict();
 	else
 		pentEntity = NULL;
 
+	// targetnames and classnames are looked up in our own lists
+	if ( szValue && *szValue && EntNames_Init( ))
+	{
+		if ( FStrEq( szKeyword, g_EntTargetnames.keyword ))
+			names = &g_EntTargetnames;
+		else if ( FStrEq( szKeyword, g_EntClassnames.keyword ))
+			names = &g_EntClassnames;
+	}
+
 	for (;;)
 	{
 		// Don't change this to use UTIL_FindEntityByString!
-		pentEntity = FIND_ENTITY_BY_STRING( pentEntity, szKeyword, szValue );
+		if ( names )
+			pentEntity = EntNames_Find( names, pentEntity, szValue );
+		else
+			pentEntity = FIND_ENTITY_BY_STRING( pentEntity, szKeyword, szValue );
 
 		// if pentEntity (the edict) is null, we're at the end of the entities. Give up.
 		if (FNullEnt(pentEntity))
@@ -247,6 +247,13 @@ extern void			UTIL_MakeVectors		(const Vector &vecAngles);
 // Pass in an array of pointers and an array size, it fills the array and returns the number inserted
 extern int			UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &center, float radius );
 extern int			UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, const Vector &maxs, int flagMask );
+extern void			UTIL_RelinkEntityGrid( edict_t *pent );
+extern void			UTIL_UnlinkEntityGrid( edict_t *pent );
+extern void			UTIL_ClearEntityGrid( void );
+extern void			UTIL_RelinkEntityNames( edict_t *pent );
+extern void			UTIL_UnlinkEntityNames( edict_t *pent );
+extern void			UTIL_SyncEntityNames( void );
+extern void			UTIL_ClearEntityNames( void );
 
 inline void UTIL_MakeVectorsPrivate( const Vector &vecAngles, float *p_vForward, float *p_vRight, float *p_vUp )
 {
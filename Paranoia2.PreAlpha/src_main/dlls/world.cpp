@@ -387,7 +387,10 @@ void CWorld :: Precache( void )
 	//LRC - set up the world lists
 	g_pWorld = this;
 	m_pAssistLink = NULL;
+	m_pAssistTail = NULL;
 	m_pFirstAlias = NULL;
+	UTIL_ClearEntityGrid();
+	UTIL_ClearEntityNames();
 //	ALERT(at_console, "Clearing AssistList\n");
 
 	g_pLastSpawn = NULL;
@@ -534,6 +534,73 @@ void QuaternionSlerp( const Vector4D &p, const Vector4D &q, float t, Vector4D &q
 	QuaternionSlerpNoAlign( p, q2, t, qt );
 }
 
+/*
+====================
+QuaternionSlerpBones
+
+Slerp the bone rotations and lerp the positions
+of two poses, the result is stored in q1 and pos1.
+Same as QuaternionSlerp and InterpolateOrigin for
+each bone, but aligned quaternions never hit the
+opposite case so it's left out, and the trig is
+skipped for the ends of the range
+====================
+*/
+void QuaternionSlerpBones( Vector4D q1[], Vector pos1[], const Vector4D q2[], const Vector pos2[], float t, int numbones )
+{
+	float	omega, cosom, sinom, sclp, sclq;
+	Vector4D	q;
+	int	i, j;
+
+	if( t <= 0.0f )
+		return; // 0.0 returns p
+
+	t = Q_min( t, 1.0f );
+
+	for( i = 0; i < numbones; i++ )
+	{
+		Vector4D &p = q1[i];
+
+		q = q2[i];
+		cosom = p[0] * q[0] + p[1] * q[1] + p[2] * q[2] + p[3] * q[3];
+
+		// decide if one of the quaternions is backwards
+		if( cosom < 0.0f )
+		{
+			q[0] = -q[0];
+			q[1] = -q[1];
+			q[2] = -q[2];
+			q[3] = -q[3];
+			cosom = -cosom;
+		}
+
+		if( t == 1.0f )
+		{
+			p = q;
+		}
+		else
+		{
+			if(( 1.0f - cosom ) > 0.000001f )
+			{
+				omega = acos( cosom );
+				sinom = sin( omega );
+				sclp = sin( (1.0f - t) * omega) / sinom;
+				sclq = sin( t * omega ) / sinom;
+			}
+			else
+			{
+				sclp = 1.0f - t;
+				sclq = t;
+			}
+
+			for( j = 0; j < 4; j++ )
+				p[j] = sclp * p[j] + sclq * q[j];
+		}
+
+		pos1[i] = pos1[i] + t * ( pos2[i] - pos1[i] );
+	}
+}
+
 //
 // lerping stuff
 //
@@ -78,6 +78,7 @@ void QuaternionAngle( const Vector4D &quat, Vector &angles, bool degrees = false
 void QuaternionAlign( const Vector4D &p, const Vector4D &q, Vector4D &qt );
 void QuaternionSlerp( const Vector4D &p, const Vector4D &q, float t, Vector4D &qt );
 void QuaternionSlerpNoAlign( const Vector4D &p, const Vector4D &q, float t, Vector4D &qt );
+void QuaternionSlerpBones( Vector4D q1[], Vector pos1[], const Vector4D q2[], const Vector pos2[], float t, int numbones );
 
 //
 // lerping stuff
@@ -201,7 +201,7 @@ matrix3x4 matrix3x4 :: Invert( void ) const
 	return out;
 }
 
-matrix3x4 matrix3x4 :: ConcatTransforms( const matrix3x4 mat2 )
+matrix3x4 matrix3x4 :: ConcatTransforms( const matrix3x4 &mat2 )
 {
 	matrix3x4 out;
 
@@ -645,7 +645,7 @@ matrix4x4 matrix4x4 :: InvertFull( void ) const
 	return *this;
 }
 
-matrix4x4 matrix4x4 :: ConcatTransforms( const matrix4x4 mat2 )
+matrix4x4 matrix4x4 :: ConcatTransforms( const matrix4x4 &mat2 )
 {
 	matrix4x4 out;
 
@@ -433,7 +433,7 @@ public:
 	}
 
 	matrix3x4 Invert( void ) const;	// basic orthonormal invert
-	matrix3x4 ConcatTransforms( const matrix3x4 mat2 );
+	matrix3x4 ConcatTransforms( const matrix3x4 &mat2 );
 
 	Vector mat[4];
 };
@@ -746,7 +746,7 @@ public:
 
 	matrix4x4 Invert( void ) const;	// basic orthonormal invert
 	matrix4x4 InvertFull( void ) const;	// full invert
-	matrix4x4 ConcatTransforms( const matrix4x4 mat2 );
+	matrix4x4 ConcatTransforms( const matrix4x4 &mat2 );
 	matrix4x4 Concat( const matrix4x4 mat2 );
 
 	void ConcatTranslate( float x, float y, float z )
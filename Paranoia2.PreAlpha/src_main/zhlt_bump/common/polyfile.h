@@ -0,0 +1,37 @@
+#ifndef POLYFILE_H__
+#define POLYFILE_H__
+
+#if _MSC_VER >= 1000
+#pragma once
+#endif
+
+//=====================================================================
+// Binary hull face files (.p0 - .p3) passed from hlcsg to hlbsp
+//
+// dpolyheader_t
+// per face:   dpolyface_t followed by numpoints * dpolypoint_t
+// end of each model: dpolyface_t with planenum -1 and no points
+//
+// Points are stored as doubles so hlbsp reads back exactly what hlcsg
+// clipped.  Files without the header are the old text format.
+
+#define POLYFILE_IDENT      (('F'<<24)+('L'<<16)+('O'<<8)+'P') // little-endian "POLF"
+#define POLYFILE_VERSION    1
+
+typedef struct
+{
+    int             ident;
+    int             version;
+} dpolyheader_t;
+
+typedef struct
+{
+    int             planenum;
+    int             texinfo;
+    int             contents;
+    int             numpoints;
+} dpolyface_t;
+
+typedef double      dpolypoint_t[3];
+
+#endif //**/ POLYFILE_H__
@@ -9,6 +9,7 @@
 #endif
 
 #include "cmdlib.h"
+#include "mathlib.h"
 #include "messages.h"
 #include "log.h"
 #include "threads.h"
@@ -34,144 +35,212 @@ q_threadpriority g_threadpriority = DEFAULT_THREAD_PRIORITY;
 #define THREADTIMES_SIZE 100
 #define THREADTIMES_SIZEf (float)(THREADTIMES_SIZE)
 
-static int      dispatch = 0;
+// largest run of work items a thread claims from a range in one go
+#define MAX_WORK_CHUNK 64
+
+#ifdef SYSTEM_WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+/*
+ * Every thread owns a contiguous slice of the work range and claims chunks off
+ * the front of it with an atomic add.  A thread that runs out of its own slice
+ * steals chunks from the others the same way, so nobody waits on ThreadLock
+ * to get its next work item.
+ */
+typedef struct
+{
+    volatile long   next;
+    long            end;
+    char            pad[64 - sizeof(long) * 2];             // keep every range on its own cache line
+}
+threadrange_t;
+
+static threadrange_t threadranges[MAX_THREADS];
+static int      numranges = 0;
+static int      workchunk = 1;
 static int      workcount = 0;
-static int      oldf = 0;
+static volatile long dispatched = 0;
+static volatile long oldf = 0;
 static bool     pacifier = false;
 static bool     threaded = false;
 static double   threadstart = 0;
 static double   threadtimes[THREADTIMES_SIZE];
 
-int             GetThreadWork()
+static THREAD_LOCAL int threadnum;
+static THREAD_LOCAL int chunknext;
+static THREAD_LOCAL int chunkend;
+
+static long     AtomicAdd(volatile long* value, const long add)
 {
-    int             r, f, i;
-    double          ct, finish, finish2, finish3;
+#ifdef SYSTEM_WIN32
+    return InterlockedExchangeAdd((LONG*)value, add);
+#else
+    return __sync_fetch_and_add(value, add);
+#endif
+}
+
+static bool     AtomicSwapIf(volatile long* value, const long oldvalue, const long newvalue)
+{
+#ifdef SYSTEM_WIN32
+    return InterlockedCompareExchange((LONG*)value, newvalue, oldvalue) == oldvalue;
+#else
+    return __sync_bool_compare_and_swap(value, oldvalue, newvalue);
+#endif
+}
+
+static void     ThreadWorkInit(const int workcnt, const bool showpacifier, const int numthreads)
+{
+    int             i;
+    long            slice;
+
+    for (i = 0; i < THREADTIMES_SIZE; i++)
+    {
+        threadtimes[i] = 0;
+    }
+    threadstart = I_FloatTime();
 
-    ThreadLock();
+    workcount = workcnt;
+    dispatched = 0;
+    oldf = -1;
+    pacifier = showpacifier;
+
+    numranges = max(1, min(numthreads, MAX_THREADS));
+    workchunk = max(1, min(MAX_WORK_CHUNK, workcnt / (numranges * 32)));
 
-    if (dispatch == 0)
+    slice = (workcnt + numranges - 1) / numranges;
+    for (i = 0; i < numranges; i++)
     {
-        oldf = 0;
+        threadranges[i].next = min((long)workcnt, slice * i);
+        threadranges[i].end = min((long)workcnt, slice * (i + 1));
     }
 
-    if (dispatch > workcount)
+    threadnum = 0;
+    chunknext = chunkend = 0;
+}
+
+static void     ThreadWorkBegin(const int thread)
+{
+    threadnum = thread % numranges;
+    chunknext = chunkend = 0;
+}
+
+static bool     ClaimChunk(threadrange_t* range)
+{
+    long            first;
+
+    if (range->next >= range->end)
     {
-        Developer(DEVELOPER_LEVEL_ERROR, "dispatch > workcount!!!\n");
-        ThreadUnlock();
-        return -1;
+        return false;
     }
-    if (dispatch == workcount)
+
+    first = AtomicAdd(&range->next, workchunk);
+    if (first >= range->end)
     {
-        Developer(DEVELOPER_LEVEL_MESSAGE, "dispatch == workcount, work is complete\n");
-        ThreadUnlock();
-        return -1;
+        return false;
     }
-    if (dispatch < 0)
+
+    chunknext = first;
+    chunkend = min(first + workchunk, range->end);
+    AtomicAdd(&dispatched, chunkend - chunknext);
+    return true;
+}
+
+static void     UpdatePacifier()
+{
+    long            f, lastf;
+    int             i;
+    double          ct, finish, finish2, finish3;
+
+    f = THREADTIMES_SIZE * (long long)dispatched / max(workcount, 1);
+    lastf = oldf;
+
+    // only the thread that moves the percentage on gets to print it
+    if (f == lastf || !AtomicSwapIf(&oldf, lastf, f))
     {
-        Developer(DEVELOPER_LEVEL_ERROR, "negative dispatch!!!\n");
-        ThreadUnlock();
-        return -1;
+        return;
     }
 
-    f = THREADTIMES_SIZE * dispatch / workcount;
     if (pacifier)
     {
-        printf("\r%6d /%6d", dispatch, workcount);
-#ifdef ZHLT_PROGRESSFILE // AJM
-        if (g_progressfile)
-        {
-            
+        printf("\r%6ld /%6d", min((long)dispatched, (long)workcount), workcount);
 
+        ct = I_FloatTime();
+        /* Fill in current time for threadtimes record */
+        for (i = max(lastf, 0L); i <= f && i < THREADTIMES_SIZE; i++)
+        {
+            if (threadtimes[i] < 1)
+            {
+                threadtimes[i] = ct;
+            }
         }
-#endif
 
-        if (f != oldf)
+        if (f > 10 && f < THREADTIMES_SIZE)
         {
-            ct = I_FloatTime();
-            /* Fill in current time for threadtimes record */
-            for (i = oldf; i <= f; i++)
+            finish = (ct - threadtimes[0]) * (THREADTIMES_SIZEf - f) / f;
+            finish2 = 10.0 * (ct - threadtimes[f - 10]) * (THREADTIMES_SIZEf - f) / THREADTIMES_SIZEf;
+            finish3 = THREADTIMES_SIZEf * (ct - threadtimes[f - 1]) * (THREADTIMES_SIZEf - f) / THREADTIMES_SIZEf;
+
+            if (finish > 1.0)
             {
-                if (threadtimes[i] < 1)
-                {
-                    threadtimes[i] = ct;
-                }
+                printf("  (%ld%%: est. time to completion %ld/%ld/%ld secs)   ", f, (long)(finish), (long)(finish2),
+                       (long)(finish3));
             }
-            oldf = f;
-
-            if (f > 10)
+            else
             {
-                finish = (ct - threadtimes[0]) * (THREADTIMES_SIZEf - f) / f;
-                finish2 = 10.0 * (ct - threadtimes[f - 10]) * (THREADTIMES_SIZEf - f) / THREADTIMES_SIZEf;
-                finish3 = THREADTIMES_SIZEf * (ct - threadtimes[f - 1]) * (THREADTIMES_SIZEf - f) / THREADTIMES_SIZEf;
-
-                if (finish > 1.0)
-                {
-                    printf("  (%d%%: est. time to completion %ld/%ld/%ld secs)   ", f, (long)(finish), (long)(finish2),
-                           (long)(finish3));
-#ifdef ZHLT_PROGRESSFILE // AJM
-                    if (g_progressfile)
-                    {
-
-
-                    }
-#endif
-                }
-                else
-                {
-                    printf("  (%d%%: est. time to completion <1 sec)   ", f);
-
-#ifdef ZHLT_PROGRESSFILE // AJM
-                    if (g_progressfile)
-                    {
-
-
-                    }
-#endif
-                }
+                printf("  (%ld%%: est. time to completion <1 sec)   ", f);
             }
         }
     }
     else
     {
-        if (f != oldf)
+        for (i = max(lastf + 1, 1L); i <= f; i++)
         {
-            oldf = f;
-            switch (f)
+            if (i % 10 == 0)
             {
-            case 10:
-            case 20:
-            case 30:
-            case 40:
-            case 50:
-            case 60:
-            case 70:
-            case 80:
-            case 90:
-            case 100:
-/*
-            case 5:
-            case 15:
-            case 25:
-            case 35:
-            case 45:
-            case 55:
-            case 65:
-            case 75:
-            case 85:
-            case 95:
-*/
-                printf("%d%%...", f);
-            default:
-                break;
+                printf("%d%%...", i);
             }
         }
     }
+}
 
-    r = dispatch;
-    dispatch++;
+// index of the calling worker, 0 .. g_numthreads - 1 (0 outside RunThreadsOn)
+int             GetThreadNum()
+{
+    return threadnum;
+}
+
+// adds to *value without taking the lock, returns the previous value
+long            ThreadAtomicAdd(volatile long* value, const long add)
+{
+    return AtomicAdd(value, add);
+}
+
+int             GetThreadWork()
+{
+    int             i;
+
+    if (chunknext >= chunkend)
+    {
+        // own range first, then steal from the neighbours
+        for (i = 0; i < numranges; i++)
+        {
+            if (ClaimChunk(&threadranges[(threadnum + i) % numranges]))
+            {
+                break;
+            }
+        }
+        if (i == numranges)
+        {
+            Developer(DEVELOPER_LEVEL_MESSAGE, "dispatch == workcount, work is complete\n");
+            return -1;
+        }
+        UpdatePacifier();
+    }
 
-    ThreadUnlock();
-    return r;
+    return chunknext++;
 }
 
 q_threadfunction workfunction;
@@ -310,6 +379,7 @@ q_threadfunction q_entry;
 
 static DWORD WINAPI ThreadEntryStub(LPVOID pParam)
 {
+    ThreadWorkBegin((int)pParam);
     q_entry((int)pParam);
     return 0;
 }
@@ -332,25 +402,17 @@ void            RunThreadsOn(int workcnt, bool showpacifier, q_threadfunction fu
     int             i;
     double          start, end;
 
-    threadstart = I_FloatTime();
-    start = threadstart;
-    for (i = 0; i < THREADTIMES_SIZE; i++)
+    if (workcnt < 0)
     {
-        threadtimes[i] = 0;
+        Developer(DEVELOPER_LEVEL_ERROR, "RunThreadsOn: negative workcount(%i)\n", workcnt);
     }
-    dispatch = 0;
-    workcount = workcnt;
-    oldf = -1;
-    pacifier = showpacifier;
+    hlassume(workcnt >= 0, assume_BadWorkcount);
+
+    ThreadWorkInit(workcnt, showpacifier, g_numthreads);
+    start = threadstart;
     threaded = true;
     q_entry = func;
 
-    if (workcount < dispatch)
-    {
-        Developer(DEVELOPER_LEVEL_ERROR, "RunThreadsOn: Workcount(%i) < dispatch(%i)\n", workcount, dispatch);
-    }
-    hlassume(workcount >= dispatch, assume_BadWorkcount);
-
     //
     // Create all the threads (suspended)
     //
@@ -499,6 +561,7 @@ q_threadfunction q_entry;
 
 static void*    CDECL ThreadEntryStub(void* pParam)
 {
+    ThreadWorkBegin((int)pParam);
     q_entry((int)pParam);
     return NULL;
 }
@@ -540,17 +603,8 @@ void            RunThreadsOn(int workcnt, bool showpacifier, q_threadfunction fu
     pthread_attr_t  attrib;
     double          start, end;
 
-    threadstart = I_FloatTime();
+    ThreadWorkInit(workcnt, showpacifier, g_numthreads);
     start = threadstart;
-    for (i = 0; i < THREADTIMES_SIZE; i++)
-    {
-        threadtimes[i] = 0;
-    }
-
-    dispatch = 0;
-    workcount = workcnt;
-    oldf = -1;
-    pacifier = showpacifier;
     threaded = true;
     q_entry = func;
 
@@ -644,19 +698,10 @@ void            ThreadUnlock()
 
 void            RunThreadsOn(int workcnt, bool showpacifier, q_threadfunction func)
 {
-    int             i;
     double          start, end;
 
-    dispatch = 0;
-    workcount = workcnt;
-    oldf = -1;
-    pacifier = showpacifier;
-    threadstart = I_FloatTime();
+    ThreadWorkInit(workcnt, showpacifier, 1);
     start = threadstart;
-    for (i = 0; i < THREADTIMES_SIZE; i++)
-    {
-        threadtimes[i] = 0.0;
-    }
 
     if (pacifier)
     {
@@ -32,6 +32,8 @@ extern q_threadpriority g_threadpriority;
 extern void     ThreadSetPriority(q_threadpriority type);
 extern void     ThreadSetDefault();
 extern int      GetThreadWork();
+extern int      GetThreadNum();
+extern long     ThreadAtomicAdd(volatile long* value, long add);
 extern void     ThreadLock();
 extern void     ThreadUnlock();
 
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "mathlib.h"
 #include "hlassert.h"
+#include "threads.h"
 
 #undef BOGUS_RANGE
 #undef ON_EPSILON
@@ -19,6 +20,141 @@
 #define ON_EPSILON 0.01
 #endif
 
+// =====================================================================================
+//  Point pool
+//      Point arrays are recycled through per-thread free lists, one list per group of
+//      4 points, so that clipping in many threads at once does not serialize on the heap.
+//      Each thread only ever touches the pool of its own thread number. A block freed by
+//      another thread than the one that allocated it goes back to the heap instead.
+// =====================================================================================
+
+#define WINDING_POOL_CLASSES    (MAX_POINTS_ON_WINDING / 4)
+#define WINDING_POOL_OVERSIZE   -1
+
+typedef union windingblock_u
+{
+    union windingblock_u* next;                            // while on a free list
+    struct
+    {
+        short           sizeclass;
+        short           owner;                             // thread number of the pool
+    } info;                                                // while handed out
+    double          align[2];                              // keeps the points 16 byte aligned
+} windingblock_t;
+
+typedef struct
+{
+    windingblock_t* freelist[WINDING_POOL_CLASSES];
+    int             held;                                  // bytes taken from the heap, the lists are never trimmed
+    unsigned        allocs;
+    unsigned        reused;
+    unsigned        foreign;                               // blocks of other threads given back to the heap
+    char            pad[64];                               // keep pools of different threads off the same cache line
+} windingpool_t;
+
+static windingpool_t s_windingpools[MAX_THREADS];
+
+static vec3_t*  AllocPoints(const UINT32 numpoints)
+{
+    int             thread = GetThreadNum();
+    windingpool_t*  pool = &s_windingpools[thread];
+    windingblock_t* block;
+    int             sizeclass = ((numpoints + 3) >> 2) - 1;
+    int             size;
+
+    if (sizeclass < 0)
+    {
+        sizeclass = 0;
+    }
+
+    pool->allocs++;
+    if (sizeclass >= WINDING_POOL_CLASSES)
+    {
+        block = (windingblock_t*)malloc(sizeof(windingblock_t) + numpoints * sizeof(vec3_t));
+        hlassume(block != NULL, assume_NoMemory);
+        block->info.sizeclass = WINDING_POOL_OVERSIZE;
+        block->info.owner = thread;
+        return (vec3_t*)(block + 1);
+    }
+
+    size = (sizeclass + 1) * 4 * (int)sizeof(vec3_t);
+    block = pool->freelist[sizeclass];
+    if (block)
+    {
+        pool->freelist[sizeclass] = block->next;
+        pool->reused++;
+    }
+    else
+    {
+        block = (windingblock_t*)malloc(sizeof(windingblock_t) + size);
+        hlassume(block != NULL, assume_NoMemory);
+        pool->held += size;
+    }
+    block->info.sizeclass = sizeclass;
+    block->info.owner = thread;
+
+    return (vec3_t*)(block + 1);
+}
+
+static void     FreePoints(vec3_t* points)
+{
+    int             thread = GetThreadNum();
+    windingpool_t*  pool = &s_windingpools[thread];
+    windingblock_t* block;
+    int             sizeclass;
+
+    if (!points)
+    {
+        return;
+    }
+
+    block = (windingblock_t*)points - 1;
+    sizeclass = block->info.sizeclass;
+    if (sizeclass == WINDING_POOL_OVERSIZE)
+    {
+        free(block);
+        return;
+    }
+
+    if (block->info.owner != thread)
+    {
+        // the owner's lists can't be touched from here
+        pool->foreign++;
+        free(block);
+        return;
+    }
+
+    block->next = pool->freelist[sizeclass];
+    pool->freelist[sizeclass] = block;
+}
+
+// =====================================================================================
+//  WindingPoolStats
+//      Reports how much the point pool saved and the largest memory held by a thread
+// =====================================================================================
+void            WindingPoolStats()
+{
+    unsigned        allocs = 0;
+    unsigned        reused = 0;
+    unsigned        foreign = 0;
+    int             peak = 0;
+    int             i;
+
+    for (i = 0; i < MAX_THREADS; i++)
+    {
+        allocs += s_windingpools[i].allocs;
+        reused += s_windingpools[i].reused;
+        foreign += s_windingpools[i].foreign;
+        peak = max(peak, s_windingpools[i].held);
+    }
+
+    if (allocs)
+    {
+        Verbose("Winding points: %u allocations, %u reused (%.1f%%), %u freed by other threads, thread peak %d bytes\n",
+                allocs, reused, reused * 100.0 / allocs, foreign, peak);
+    }
+}
+
 //
 // Winding Public Methods
 //
@@ -252,7 +388,7 @@ Winding::Winding(vec3_t *points, UINT32 numpoints)
 	m_NumPoints = numpoints;
 	m_MaxPoints = (m_NumPoints + 3) & ~3;	// groups of 4
 
-	m_Points = new vec3_t[m_MaxPoints];
+	m_Points = AllocPoints(m_MaxPoints);
 	memcpy(m_Points, points, sizeof(vec3_t) * m_NumPoints);
 }
 
@@ -265,17 +401,17 @@ void			Winding::initFromPoints(vec3_t *points, UINT32 numpoints)
 	m_NumPoints = numpoints;
 	m_MaxPoints = (m_NumPoints + 3) & ~3;	// groups of 4
 
-	m_Points = new vec3_t[m_MaxPoints];
+	m_Points = AllocPoints(m_MaxPoints);
 	memcpy(m_Points, points, sizeof(vec3_t) * m_NumPoints);
 }
 
 Winding&      Winding::operator=(const Winding& other)
 {
-    delete[] m_Points;
+    FreePoints(m_Points);
     m_NumPoints = other.m_NumPoints;
     m_MaxPoints = (m_NumPoints + 3) & ~3;   // groups of 4
 
-    m_Points = new vec3_t[m_MaxPoints];
+    m_Points = AllocPoints(m_MaxPoints);
     memcpy(m_Points, other.m_Points, sizeof(vec3_t) * m_NumPoints);
     return *this;
 }
@@ -287,7 +423,7 @@ Winding::Winding(UINT32 numpoints)
     m_NumPoints = numpoints;
     m_MaxPoints = (m_NumPoints + 3) & ~3;   // groups of 4
 
-    m_Points = new vec3_t[m_MaxPoints];
+    m_Points = AllocPoints(m_MaxPoints);
     memset(m_Points, 0, sizeof(vec3_t) * m_NumPoints);
 }
 
@@ -296,13 +432,13 @@ Winding::Winding(const Winding& other)
     m_NumPoints = other.m_NumPoints;
     m_MaxPoints = (m_NumPoints + 3) & ~3;   // groups of 4
 
-    m_Points = new vec3_t[m_MaxPoints];
+    m_Points = AllocPoints(m_MaxPoints);
     memcpy(m_Points, other.m_Points, sizeof(vec3_t) * m_NumPoints);
 }
 
 Winding::~Winding()
 {
-    delete[] m_Points;
+    FreePoints(m_Points);
 }
 
 
@@ -355,7 +491,7 @@ void Winding::initFromPlane(const vec3_t normal, const vec_t dist)
 
     // project a really big     axis aligned box onto the plane
     m_NumPoints = 4;
-    m_Points = new vec3_t[m_NumPoints];
+    m_Points = AllocPoints(m_NumPoints);
 
     VectorSubtract(org, vright, m_Points[0]);
     VectorAdd(m_Points[0], vup, m_Points[0]);
@@ -382,7 +518,7 @@ Winding::Winding(const dface_t& face)
     int             v;
 
     m_NumPoints = face.numedges;
-    m_Points = new vec3_t[m_NumPoints];
+    m_Points = AllocPoints(m_NumPoints);
 
     unsigned i;
     for (i = 0; i < face.numedges; i++)
@@ -712,7 +848,7 @@ bool          Winding::Chop(const vec3_t normal, const vec_t dist)
 
     if (f)
     {
-        delete[] m_Points;
+        FreePoints(m_Points);
         m_NumPoints = f->m_NumPoints;
         m_Points = f->m_Points;
         f->m_Points = NULL;
@@ -722,7 +858,7 @@ bool          Winding::Chop(const vec3_t normal, const vec_t dist)
     else
     {
         m_NumPoints = 0;
-        delete[] m_Points;
+        FreePoints(m_Points);
         m_Points = NULL;
         return false;
     }
@@ -812,7 +948,7 @@ bool Winding::Clip(const dplane_t& split, bool keepon)
 
     if (!counts[0])
     {
-        delete[] m_Points;
+        FreePoints(m_Points);
         m_Points = NULL;
         m_NumPoints = 0;
         return false;
@@ -825,7 +961,7 @@ bool Winding::Clip(const dplane_t& split, bool keepon)
 
     unsigned maxpts = m_NumPoints + 4;                            // can't use counts[0]+2 because of fp grouping errors
     unsigned newNumPoints = 0;
-    vec3_t* newPoints = new vec3_t[maxpts];
+    vec3_t* newPoints = AllocPoints(maxpts);
     memset(newPoints, 0, sizeof(vec3_t) * maxpts);
 
     for (i = 0; i < m_NumPoints; i++)
@@ -886,7 +1022,7 @@ bool Winding::Clip(const dplane_t& split, bool keepon)
         Error("Winding::Clip : points exceeded estimate");
     }
 
-    delete[] m_Points;
+    FreePoints(m_Points);
     m_Points = newPoints;
     m_NumPoints = newNumPoints;
 
@@ -1076,10 +1212,10 @@ void            Winding::resize(UINT32 newsize)
 {
     newsize = (newsize + 3) & ~3;   // groups of 4
 
-    vec3_t* newpoints = new vec3_t[newsize];
+    vec3_t* newpoints = AllocPoints(newsize);
     m_NumPoints = min(newsize, m_NumPoints);
     memcpy(newpoints, m_Points, m_NumPoints);
-    delete[] m_Points;
+    FreePoints(m_Points);
     m_Points = newpoints;
     m_MaxPoints = newsize;
 }
@@ -1101,9 +1237,9 @@ void			Winding::Reset(void)
 {
 	if(m_Points)
 	{
-		delete [] m_Points;
+		FreePoints(m_Points);
 		m_Points = NULL;
 	}
 
 	m_NumPoints = m_MaxPoints = 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
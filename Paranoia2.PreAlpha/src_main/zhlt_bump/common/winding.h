@@ -17,6 +17,8 @@
 
 #define BASE_WINDING_DISTANCE 9000
 
+extern void     WindingPoolStats();
+
 #define	SIDE_FRONT		0
 #define	SIDE_ON			2
 #define	SIDE_BACK		1
@@ -79,4 +81,4 @@ protected:
     UINT32  m_MaxPoints;
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
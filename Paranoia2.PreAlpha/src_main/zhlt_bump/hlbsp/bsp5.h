@@ -16,6 +16,7 @@
 #include "filelib.h"
 #include "threads.h"
 #include "winding.h"
+#include "polyfile.h"
 
 #define ENTITIES_VOID "entities.void"
 #define ENTITIES_VOID_EXT ".void"
@@ -22,7 +22,10 @@
 
 */
 
-static FILE*    polyfiles[NUM_HULLS];
+static FILE*    polyfiles[NUM_HULLS];              // text hull files from hlcsg -textpolys
+static byte*    polydata[NUM_HULLS];               // binary hull files, loaded whole
+static const byte* polycursor[NUM_HULLS];
+static const byte* polyend[NUM_HULLS];
 int             g_hullnum = 0;
 
 static face_t*  validfaces[MAX_MAP_PLANES];
@@ -628,9 +631,9 @@ static          facestyle_e SetFaceType(face_t* f)
 }
 
 // =====================================================================================
-//  ReadSurfs
+//  ReadSurfsText
 // =====================================================================================
-static surfchain_t* ReadSurfs(FILE* file)
+static surfchain_t* ReadSurfsText(FILE* file)
 {
     int             r;
     int             planenum, g_texinfo, contents, numpoints;
@@ -713,6 +716,127 @@ static surfchain_t* ReadSurfs(FILE* file)
     return SurflistFromValidFaces();
 }
 
+// =====================================================================================
+//  ReadSurfsBinary
+//      walks the faces of one model straight out of the loaded hull file
+// =====================================================================================
+static surfchain_t* ReadSurfsBinary(const int hull)
+{
+    const dpolyface_t*  face;
+    const dpolypoint_t* points;
+    face_t*         f;
+    int             i;
+    int             facenum = 0;
+
+    while (1)
+    {
+        if (polycursor[hull] >= polyend[hull])
+        {
+            return NULL;
+        }
+        if (polycursor[hull] + sizeof(dpolyface_t) > polyend[hull])
+        {
+            Error("ReadSurfs (hull %i, face %i): unexpected end of file", hull, facenum);
+        }
+
+        face = (const dpolyface_t*)polycursor[hull];
+        points = (const dpolypoint_t*)(face + 1);
+        polycursor[hull] = (const byte*)(points + face->numpoints);
+        facenum++;
+
+        if (face->planenum == -1)                          // end of model
+        {
+            break;
+        }
+        if (face->numpoints < 0 || polycursor[hull] > polyend[hull])
+        {
+            Error("ReadSurfs (hull %i, face %i): unexpected end of file", hull, facenum);
+        }
+        if (face->numpoints > MAXPOINTS)
+        {
+            Error("ReadSurfs (hull %i, face %i): %i > MAXPOINTS\nThis is caused by a face with too many verticies (typically found on end-caps of high-poly cylinders)\n", hull, facenum, face->numpoints);
+        }
+        if (face->planenum > g_numplanes)
+        {
+            Error("ReadSurfs (hull %i, face %i): %i > g_numplanes\n", hull, facenum, face->planenum);
+        }
+        if (face->texinfo > g_numtexinfo)
+        {
+            Error("ReadSurfs (hull %i, face %i): %i > g_numtexinfo", hull, facenum, face->texinfo);
+        }
+
+        if (!strcasecmp(GetTextureByNumber(face->texinfo), "skip"))
+        {
+            Verbose("ReadSurfs (hull %i, face %i): skipping a surface", hull, facenum);
+            continue;
+        }
+
+        f = AllocFace();
+        f->planenum = face->planenum;
+        f->texturenum = face->texinfo;
+        f->contents = face->contents;
+        f->numpoints = face->numpoints;
+        f->next = validfaces[face->planenum];
+        validfaces[face->planenum] = f;
+
+        SetFaceType(f);
+
+        for (i = 0; i < f->numpoints; i++)
+        {
+            VectorCopy(points[i], f->pts[i]);
+        }
+    }
+
+    return SurflistFromValidFaces();
+}
+
+// =====================================================================================
+//  ReadSurfs
+//      reads the next model from a hull file, in whichever format hlcsg wrote it
+// =====================================================================================
+static surfchain_t* ReadSurfs(const int hull)
+{
+    if (polydata[hull])
+    {
+        return ReadSurfsBinary(hull);
+    }
+    return ReadSurfsText(polyfiles[hull]);
+}
+
+// =====================================================================================
+//  OpenPolyFile
+// =====================================================================================
+static void     OpenPolyFile(const int hull, const char* const name)
+{
+    dpolyheader_t   header;
+    int             length;
+    FILE*           f;
+
+    f = fopen(name, "rb");
+    if (!f)
+        Error("Can't open %s", name);
+
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.ident != POLYFILE_IDENT)
+    {
+        // not ours, must be a text file from hlcsg -textpolys
+        fclose(f);
+        polyfiles[hull] = fopen(name, "r");
+        if (!polyfiles[hull])
+            Error("Can't open %s", name);
+        return;
+    }
+    fclose(f);
+
+    if (header.version != POLYFILE_VERSION)
+    {
+        Error("%s is version %i, not %i (hlcsg and hlbsp are out of date with each other)", name, header.version, POLYFILE_VERSION);
+    }
+
+    length = LoadFile(name, (char**)&polydata[hull]);
+    polycursor[hull] = polydata[hull] + sizeof(dpolyheader_t);
+    polyend[hull] = polydata[hull] + length;
+}
+
 
 #ifdef HLBSP_THREADS// AJM
 // =====================================================================================
@@ -726,7 +850,7 @@ void            ProcessModel(int modelnum)
     dmodel_t*       model;
     int             startleafs;
 
-    surfs = ReadSurfs(polyfiles[0]);
+    surfs = ReadSurfs(0);
 
     if (!surfs)
         return; // all models are done
@@ -775,7 +899,7 @@ void            ProcessModel(int modelnum)
     // the clipping hulls are simpler
     for (g_hullnum = 1; g_hullnum < NUM_HULLS; g_hullnum++)
     {
-        surfs = ReadSurfs(polyfiles[g_hullnum]);
+        surfs = ReadSurfs(g_hullnum);
         nodes = SolidBSP(surfs);
         if (g_nummodels == 1 && !g_nofill)                   // assume non-world bmodels are simple
         {
@@ -804,7 +928,7 @@ static bool     ProcessModel()
     dmodel_t*       model;
     int             startleafs;
 
-    surfs = ReadSurfs(polyfiles[0]);
+    surfs = ReadSurfs(0);
 
     if (!surfs)
         return false;                                      // all models are done
@@ -853,7 +977,7 @@ static bool     ProcessModel()
     // the clipping hulls are simpler
     for (g_hullnum = 1; g_hullnum < NUM_HULLS; g_hullnum++)
     {
-        surfs = ReadSurfs(polyfiles[g_hullnum]);
+        surfs = ReadSurfs(g_hullnum);
         nodes = SolidBSP(surfs);
         if (g_nummodels == 1 && !g_nofill)                   // assume non-world bmodels are simple
         {
@@ -1004,10 +1128,7 @@ static void     ProcessFile(const char* const filename)
     {
                    //mapname.p[0-3]
         sprintf(name, "%s.p%i", filename, i);
-        polyfiles[i] = fopen(name, "r");
-
-        if (!polyfiles[i])
-            Error("Can't open %s", name);
+        OpenPolyFile(i, name);
     }
 
     // load the output of csg
@@ -1321,6 +1442,8 @@ int             main(const int argc, char** argv)
 
     ProcessFile(g_Mapname); 
 
+    WindingPoolStats();
+
     end = I_FloatTime();
     LogTimeElapsed(end - start);
     // END BSP
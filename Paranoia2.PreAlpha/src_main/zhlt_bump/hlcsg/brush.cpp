@@ -9,71 +9,119 @@ int             g_nummapplanes;
 #define DIST_EPSILON   0.01
 #endif
 
+// planes are hashed on their distance from the origin; a bucket is wide
+// enough that a plane matching within NORMAL_EPSILON/DIST_EPSILON anywhere
+// inside BOGUS_RANGE is always found in its own or a neighbouring bucket
+#define PLANE_HASHES        4096
+#define PLANE_HASH_WIDTH    8.0
+
+static volatile int s_planehash[PLANE_HASHES];             // first plane in bucket + 1, 0 when empty
+static volatile int s_planechain[MAX_MAP_PLANES];          // next plane in bucket + 1
+
+static int      PlaneHashForDist(const vec_t dist)
+{
+    return (int)floor(dist / PLANE_HASH_WIDTH) & (PLANE_HASHES - 1);
+}
+
+static void     AddPlaneToHash(const int planenum)
+{
+    const int       hash = PlaneHashForDist(g_mapplanes[planenum].dist);
+
+    s_planechain[planenum] = s_planehash[hash];
+    s_planehash[hash] = planenum + 1;
+}
+
 /*
  * =============
- * FindIntPlane
- * 
- * Returns which plane number to use for a given integer defined plane.
+ * FindPlaneInHash
  * 
+ * Returns the lowest numbered plane matching normal/origin, or -1.  Lowest so
+ * the numbering is the same as scanning g_mapplanes from the start.
  * =============
  */
-int             FindIntPlane(const vec_t* const normal, const vec_t* const origin)
+static int      FindPlaneInHash(const vec_t* const normal, const vec_t* const origin)
 {
-    int             i, j;
-    plane_t*        p;
-    plane_t         temp;
+    int             i, j, h;
+    int             hash;
+    int             best;
+    const plane_t*  p;
     vec_t           t;
-    bool            locked;
 
-    p = g_mapplanes;
-    locked = false;
-    i = 0;
+    hash = PlaneHashForDist(DotProduct(origin, normal));
+    best = -1;
 
-    while (1)
+    for (h = -1; h <= 1; h++)
     {
-        if (i == g_nummapplanes)
+        for (i = s_planehash[(hash + h) & (PLANE_HASHES - 1)] - 1; i >= 0; i = s_planechain[i] - 1)
         {
-            if (!locked)
-            {
-                locked = true;
-                ThreadLock();                              // make sure we don't race
-            }
-            if (i == g_nummapplanes)
+            if (best >= 0 && i >= best)
             {
-                break;                                     // we didn't race
+                continue;
             }
-        }
 
-        t = 0;                                             // Unrolled loop
-        t += (origin[0] - p->origin[0]) * normal[0];
-        t += (origin[1] - p->origin[1]) * normal[1];
-        t += (origin[2] - p->origin[2]) * normal[2];
+            p = &g_mapplanes[i];
 
-        if (fabs(t) < DIST_EPSILON)
-        {                                                  // on plane
-            // see if the normal is forward, backwards, or off
-            for (j = 0; j < 3; j++)
-            {
-                if (fabs(normal[j] - p->normal[j]) > NORMAL_EPSILON)
+            t = 0;                                         // Unrolled loop
+            t += (origin[0] - p->origin[0]) * normal[0];
+            t += (origin[1] - p->origin[1]) * normal[1];
+            t += (origin[2] - p->origin[2]) * normal[2];
+
+            if (fabs(t) < DIST_EPSILON)
+            {                                              // on plane
+                // see if the normal is forward, backwards, or off
+                for (j = 0; j < 3; j++)
                 {
-                    break;
+                    if (fabs(normal[j] - p->normal[j]) > NORMAL_EPSILON)
+                    {
+                        break;
+                    }
                 }
-            }
-            if (j == 3)
-            {
-                if (locked)
+                if (j == 3)
                 {
-                    ThreadUnlock();
+                    best = i;
                 }
-                return i;
             }
         }
+    }
 
-        i++;
-        p++;
+    return best;
+}
+
+/*
+ * =============
+ * FindIntPlane
+ * 
+ * Returns which plane number to use for a given integer defined plane.
+ * 
+ * =============
+ */
+int             FindIntPlane(const vec_t* const normal, const vec_t* const origin)
+{
+    int             i;
+    plane_t*        p;
+    plane_t         temp;
+
+    // planes are only ever appended and hashed after they are filled in,
+    // so a lookup without the lock can only miss a plane, never see half of one
+    i = FindPlaneInHash(normal, origin);
+    if (i >= 0)
+    {
+        return i;
+    }
+
+    ThreadLock();                                          // make sure we don't race
+
+    i = FindPlaneInHash(normal, origin);
+    if (i >= 0)
+    {
+        ThreadUnlock();
+        return i;
     }
 
-    hlassert(locked);
+    hlassume(g_nummapplanes < MAX_MAP_PLANES, assume_MAX_MAP_PLANES);
+
+    i = g_nummapplanes;
+    p = &g_mapplanes[i];
 
     // create a new plane
     p->origin[0] = origin[0];
@@ -92,8 +140,6 @@ int             FindIntPlane(const vec_t* const normal, const vec_t* const origi
     (p + 1)->normal[1] = -normal[1];
     (p + 1)->normal[2] = -normal[2];
 
-    hlassume(g_nummapplanes < MAX_MAP_PLANES, assume_MAX_MAP_PLANES);
-
     VectorNormalize(p->normal);
 
     p->type = (p + 1)->type = PlaneTypeForNormal(p->normal);
@@ -111,12 +157,16 @@ int             FindIntPlane(const vec_t* const normal, const vec_t* const origi
             temp = *p;
             *p = *(p + 1);
             *(p + 1) = temp;
+            AddPlaneToHash(i);
+            AddPlaneToHash(i + 1);
             g_nummapplanes += 2;
             ThreadUnlock();
             return i + 1;
         }
     }
 
+    AddPlaneToHash(i);
+    AddPlaneToHash(i + 1);
     g_nummapplanes += 2;
     ThreadUnlock();
     return i;
@@ -24,6 +24,7 @@
 #include "blockmem.h"
 #include "filelib.h"
 #include "boundingbox.h"
+#include "polyfile.h"
 // AJM: added in
 #include "wadpath.h"
 
@@ -38,6 +39,7 @@
 #define DEFAULT_WADTEXTURES true
 #define DEFAULT_SKYCLIP     true
 #define DEFAULT_CHART       false
+#define DEFAULT_TEXTPOLYS   false
 #define DEFAULT_INFO        true
 
 #ifdef ZHLT_NULLTEX // AJM
@@ -197,6 +199,7 @@ extern void     CreateBrush(int brushnum);
 // csg.c
 
 extern bool     g_chart;
+extern bool     g_textpolys;
 extern bool     g_onlyents;
 extern bool     g_noclip;
 extern bool     g_wadtextures;
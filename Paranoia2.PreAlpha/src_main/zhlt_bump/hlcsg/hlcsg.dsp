@@ -283,6 +283,10 @@ SOURCE=..\common\messages.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\common\polyfile.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\common\scriplib.h
 # End Source File
 # Begin Source File
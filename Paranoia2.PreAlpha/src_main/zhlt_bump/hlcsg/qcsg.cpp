@@ -20,6 +20,18 @@
 */
 
 static FILE*    out[NUM_HULLS]; // pointer to each of the hull out files (.p0, .p1, ect.)  
+
+// faces are collected per thread and per hull, then written in one go at the end of each model
+typedef struct
+{
+    byte*           data;
+    int             size;
+    int             maxsize;
+    int             numfaces;
+} polybuffer_t;
+
+static polybuffer_t polybuffers[MAX_THREADS][NUM_HULLS];
+
 static int      c_tiny;        
 static int      c_tiny_clip;
 static int      c_outfaces;
@@ -36,6 +48,7 @@ bool            g_noclip = DEFAULT_NOCLIP;              // no clipping hull "-no
 bool            g_onlyents = DEFAULT_ONLYENTS;          // onlyents mode "-onlyents"
 bool            g_wadtextures = DEFAULT_WADTEXTURES;    // "-nowadtextures"
 bool            g_chart = DEFAULT_CHART;                // show chart "-chart"
+bool            g_textpolys = DEFAULT_TEXTPOLYS;        // write .p0-.p3 as text "-textpolys"
 bool            g_skyclip = DEFAULT_SKYCLIP;            // no sky clipping "-noskyclip"
 bool            g_estimate = DEFAULT_ESTIMATE;          // progress estimates "-estimate"
 bool            g_info = DEFAULT_INFO;                  // "-info" ?
@@ -316,6 +329,26 @@ static bface_t* ClipFace(bface_t* f, bface_t** outside, const int splitplane, co
     }
 }
 
+// =====================================================================================
+//  PolyBufferAlloc
+//      reserves size bytes at the end of a face buffer
+// =====================================================================================
+static byte*    PolyBufferAlloc(polybuffer_t* buf, const int size)
+{
+    byte*           data;
+
+    if (buf->size + size > buf->maxsize)
+    {
+        buf->maxsize = max(buf->maxsize * 2, buf->size + size + 0x10000);
+        buf->data = (byte*)realloc(buf->data, buf->maxsize);
+        hlassume(buf->data != NULL, assume_NoMemory);
+    }
+
+    data = buf->data + buf->size;
+    buf->size += size;
+    return data;
+}
+
 // =====================================================================================
 //  WriteFace
 // =====================================================================================
@@ -324,6 +357,31 @@ void            WriteFace(const int hull, const bface_t* const f)
     unsigned int    i;
     Winding*        w;
 
+    if (!g_textpolys)
+    {
+        polybuffer_t*   buf = &polybuffers[GetThreadNum()][hull];
+        dpolyface_t*    face;
+        dpolypoint_t*   points;
+
+        w = f->w;
+        face = (dpolyface_t*)PolyBufferAlloc(buf, sizeof(dpolyface_t) + w->m_NumPoints * sizeof(dpolypoint_t));
+        face->planenum = f->planenum;
+        face->texinfo = f->texinfo;
+        face->contents = f->contents;
+        face->numpoints = w->m_NumPoints;
+
+        points = (dpolypoint_t*)(face + 1);
+        for (i = 0; i < w->m_NumPoints; i++)
+        {
+            points[i][0] = w->m_Points[i][0];
+            points[i][1] = w->m_Points[i][1];
+            points[i][2] = w->m_Points[i][2];
+        }
+
+        buf->numfaces++;
+        return;
+    }
+
     ThreadLock();
     if (!hull)
         c_csgfaces++;
@@ -972,6 +1030,38 @@ int typecontents[NUM_TYPECONTENTS] = {
 };
 
 
+// =====================================================================================
+//  FlushPolyBuffers
+//      writes every thread's faces for a hull followed by the end of model marker
+// =====================================================================================
+static void     FlushPolyBuffers(const int hull)
+{
+    dpolyface_t     endmarker;
+    polybuffer_t*   buf;
+    int             i;
+
+    for (i = 0; i < MAX_THREADS; i++)
+    {
+        buf = &polybuffers[i][hull];
+        if (buf->size)
+        {
+            SafeWrite(out[hull], buf->data, buf->size);
+        }
+        if (!hull)
+        {
+            c_csgfaces += buf->numfaces;
+        }
+        buf->size = 0;
+        buf->numfaces = 0;
+    }
+
+    endmarker.planenum = -1;
+    endmarker.texinfo = -1;
+    endmarker.contents = -1;
+    endmarker.numpoints = 0;
+    SafeWrite(out[hull], &endmarker, sizeof(endmarker));
+}
+
 static void     ProcessModels()
 {
     int             i, j, type;
@@ -1020,7 +1110,14 @@ static void     ProcessModels()
         // write end of model marker
         for (j = 0; j < NUM_HULLS; j++)
         {
-            fprintf(out[j], "-1 -1 -1 -1\n");
+            if (g_textpolys)
+            {
+                fprintf(out[j], "-1 -1 -1 -1\n");
+            }
+            else
+            {
+                FlushPolyBuffers(j);
+            }
         }
     }
 }
@@ -1111,6 +1208,7 @@ static void     Usage()
     Log("    -hullfile file   : Reads in custom collision hull dimensions\n");
     Log("    -texdata #       : Alter maximum texture memory limit (in kb)\n");
     Log("    -chart           : display bsp statitics\n");
+    Log("    -textpolys       : write the hull files as text for debugging\n");
     Log("    -low | -high     : run program an altered priority level\n");
     Log("    -nolog           : don't generate the compile logfiles\n");
     Log("    -threads #       : manually specify the number of threads to run\n");
@@ -1193,6 +1291,7 @@ static void     Settings()
 
     Log("developer             [ %7d ] [ %7d ]\n", g_developer, DEFAULT_DEVELOPER);
     Log("chart                 [ %7s ] [ %7s ]\n", g_chart ? "on" : "off", DEFAULT_CHART ? "on" : "off");
+    Log("text hull files       [ %7s ] [ %7s ]\n", g_textpolys ? "on" : "off", DEFAULT_TEXTPOLYS ? "on" : "off");
     Log("estimate              [ %7s ] [ %7s ]\n", g_estimate ? "on" : "off", DEFAULT_ESTIMATE ? "on" : "off");
     Log("max texture memory    [ %7d ] [ %7d ]\n", g_max_map_miptex, DEFAULT_MAX_MAP_MIPTEX);
 
@@ -1352,6 +1451,10 @@ int             main(const int argc, char** argv)
         {
             g_chart = true;
         }
+        else if (!strcasecmp(argv[i], "-textpolys"))
+        {
+            g_textpolys = true;
+        }
         else if (!strcasecmp(argv[i], "-low"))
         {
             g_threadpriority = eThreadPriorityLow;
@@ -1665,10 +1768,19 @@ int             main(const int argc, char** argv)
 
         safe_snprintf(name, _MAX_PATH, "%s.p%i", g_Mapname, i);
 
-        out[i] = fopen(name, "w");
+        out[i] = fopen(name, g_textpolys ? "w" : "wb");
 
         if (!out[i]) 
             Error("Couldn't open %s", name);
+
+        if (!g_textpolys)
+        {
+            dpolyheader_t   header;
+
+            header.ident = POLYFILE_IDENT;
+            header.version = POLYFILE_VERSION;
+            SafeWrite(out[i], &header, sizeof(header));
+        }
     }
 
     ProcessModels();
@@ -1713,6 +1825,8 @@ int             main(const int argc, char** argv)
 #endif
 
     // elapsed time
+    WindingPoolStats();
+
     end = I_FloatTime();
     LogTimeElapsed(end - start);
 
@@ -3,6 +3,8 @@
 edgeshare_t     g_edgeshare[MAX_MAP_EDGES];
 vec3_t          g_face_centroids[MAX_MAP_EDGES];
 bool            g_sky_lighting_fix = DEFAULT_SKY_LIGHTING_FIX;
+bool            g_fastsky = DEFAULT_FASTSKY;
+bool            g_simd = DEFAULT_SIMD;
 
 // buz
 #define LIGHTFLAG_NOT_NORMAL	2
@@ -852,8 +854,196 @@ static directlight_t* directlights[MAX_MAP_LEAFS];
 static facelight_t facelight[MAX_MAP_FACES];
 static int      numdlights;
 
+// -simd: the non-sky lights of every leaf as arrays, padded to whole batches,
+// so the falloff and cone tests run over LIGHTBATCH_WIDTH lights per loop
+#define LIGHTBATCH_WIDTH    8
+#define LIGHTBATCH_ARRAYS   12
+
+typedef struct
+{
+    int             numlights;                             // multiple of LIGHTBATCH_WIDTH, pad lanes always cull
+    directlight_t** lights;
+    vec_t*          origin[3];
+    vec_t*          normal[3];                             // zero for point lights
+    vec_t*          fade;
+    vec_t*          square;                                // 1 for inverse square falloff, 0 for inverse linear
+    vec_t*          usedot2;                               // 1 if the angle at the light counts, 0 for point lights
+    vec_t*          cullcos;                               // lights at this angle or beyond are culled
+    vec_t*          stopdot;                               // spotlight cone fade starts here
+    vec_t*          conescale;                             // 1 / (stopdot - stopdot2), 0 without a cone fade
+}
+lightbatch_t;
+
+static lightbatch_t s_lightbatches[MAX_MAP_LEAFS];
+
+enum
+{
+    LIGHTPHASE_DIRECT,                                     // whole first pass
+    LIGHTPHASE_CULL,
+    LIGHTPHASE_OCCLUSION,
+    LIGHTPHASE_SHADE,
+    LIGHTPHASE_BUMP,
+    LIGHTPHASE_COUNT
+};
+
+// thread seconds spent in each GatherSampleLight phase
+static double   s_lightphasetime[MAX_THREADS][LIGHTPHASE_COUNT];
+
 #define	DIRECT_SCALE	0.1f
 
+// =====================================================================================
+//  BuildLightBatches
+// =====================================================================================
+static void     BuildLightBatches()
+{
+    directlight_t*  l;
+    lightbatch_t*   batch;
+    vec_t*          data;
+    int             count;
+    int             i, j, k;
+
+    for (i = 0; i < g_numleafs; i++)
+    {
+        count = 0;
+        for (l = directlights[i]; l; l = l->next)
+        {
+            if (l->type != emit_skylight)
+            {
+                count++;
+            }
+        }
+        if (!count)
+        {
+            continue;
+        }
+
+        batch = &s_lightbatches[i];
+        batch->numlights = (count + LIGHTBATCH_WIDTH - 1) & ~(LIGHTBATCH_WIDTH - 1);
+        batch->lights = (directlight_t**)calloc(batch->numlights, sizeof(directlight_t*));
+        data = (vec_t*)calloc(batch->numlights * LIGHTBATCH_ARRAYS, sizeof(vec_t));
+        hlassume(batch->lights != NULL && data != NULL, assume_NoMemory);
+
+        for (k = 0; k < 3; k++)
+        {
+            batch->origin[k] = data + k * batch->numlights;
+            batch->normal[k] = data + (3 + k) * batch->numlights;
+        }
+        batch->fade = data + 6 * batch->numlights;
+        batch->square = data + 7 * batch->numlights;
+        batch->usedot2 = data + 8 * batch->numlights;
+        batch->cullcos = data + 9 * batch->numlights;
+        batch->stopdot = data + 10 * batch->numlights;
+        batch->conescale = data + 11 * batch->numlights;
+
+        // same order as the leaf list, so the sample sums in the same order
+        for (j = 0, l = directlights[i]; l; l = l->next)
+        {
+            if (l->type == emit_skylight)
+            {
+                continue;
+            }
+
+            batch->lights[j] = l;
+            for (k = 0; k < 3; k++)
+            {
+                batch->origin[k][j] = l->origin[k];
+            }
+            batch->fade[j] = l->fade;
+            batch->square[j] = (l->falloff == 2) ? 1 : 0;
+            batch->stopdot[j] = -2;
+
+            switch (l->type)
+            {
+            case emit_point:
+                batch->cullcos[j] = -2;
+                break;
+
+            case emit_surface:
+                for (k = 0; k < 3; k++)
+                {
+                    batch->normal[k][j] = l->normal[k];
+                }
+                batch->fade[j] = g_fade;
+                batch->square[j] = (g_falloff == 2) ? 1 : 0;
+                batch->usedot2[j] = 1;
+                batch->cullcos[j] = ON_EPSILON / 10;
+                break;
+
+            case emit_spotlight:
+                for (k = 0; k < 3; k++)
+                {
+                    batch->normal[k][j] = l->normal[k];
+                }
+                batch->usedot2[j] = 1;
+                batch->cullcos[j] = l->stopdot2;
+                batch->stopdot[j] = l->stopdot;
+                if (l->stopdot > l->stopdot2)
+                {
+                    batch->conescale[j] = 1 / (l->stopdot - l->stopdot2);
+                }
+                break;
+
+            default:
+                hlassume(false, assume_BadLightType);
+                break;
+            }
+            j++;
+        }
+
+        for (; j < batch->numlights; j++)
+        {
+            batch->fade[j] = 1;
+            batch->cullcos[j] = 2;                         // no angle gets past this
+            batch->stopdot[j] = -2;
+        }
+    }
+}
+
+// =====================================================================================
+//  FreeLightBatches
+// =====================================================================================
+static void     FreeLightBatches()
+{
+    int             i;
+
+    for (i = 0; i < g_numleafs; i++)
+    {
+        if (s_lightbatches[i].numlights)
+        {
+            free(s_lightbatches[i].lights);
+            free(s_lightbatches[i].origin[0]);             // head of the array block
+        }
+    }
+    memset(s_lightbatches, 0, sizeof(s_lightbatches));
+}
+
+// =====================================================================================
+//  ReportLightPhases
+// =====================================================================================
+static void     ReportLightPhases()
+{
+    double          total[LIGHTPHASE_COUNT];
+    int             i, j;
+
+    for (j = 0; j < LIGHTPHASE_COUNT; j++)
+    {
+        total[j] = 0;
+        for (i = 0; i < MAX_THREADS; i++)
+        {
+            total[j] += s_lightphasetime[i][j];
+        }
+    }
+
+    Verbose("direct lights %.2f seconds, bump pass %.2f seconds (summed over threads)\n",
+            total[LIGHTPHASE_DIRECT], total[LIGHTPHASE_BUMP]);
+    if (g_simd)
+    {
+        Verbose("  cull %.2f, occlusion %.2f, shading %.2f seconds\n",
+                total[LIGHTPHASE_CULL], total[LIGHTPHASE_OCCLUSION], total[LIGHTPHASE_SHADE]);
+    }
+    memset(s_lightphasetime, 0, sizeof(s_lightphasetime));
+}
+
 // =====================================================================================
 //  CreateDirectLights
 // =====================================================================================
@@ -1182,6 +1372,11 @@ void            CreateDirectLights()
 
     hlassume(numdlights, assume_NoLights);
     Log("%i direct lights\n", numdlights);
+
+    if (g_simd)
+    {
+        BuildLightBatches();
+    }
 }
 
 // =====================================================================================
@@ -1203,6 +1398,9 @@ void            DeleteDirectLights()
         }
     }
 
+    ReportLightPhases();
+    FreeLightBatches();
+
     // AJM: todo: strip light entities out at this point
 }
 
@@ -1269,6 +1467,355 @@ enum {
 double          r_avertexnormals[NUMVERTEXNORMALS][3] = {
 #include "../common/anorms.h"
 };
+
+// =====================================================================================
+//  Sky probes
+//      -fastsky: the indirect sun pass traces every r_avertexnormals direction from every
+//      sample. Instead, each direction is first looked up in the 8 probes on the world-space
+//      grid around the sample. If they all agree, their answer is used. Only the directions
+//      where they disagree (sky edges) are traced from the sample itself. Probes inside solid
+//      or sky have no answer; when none of the 8 has one, every direction is traced.
+//      Probes are built lazily by whichever BuildFacelights thread needs them first.
+// =====================================================================================
+#define SKYPROBE_GRID       64.0
+#define SKYPROBE_HASHES     65536
+#define SKYPROBE_MASKBYTES  ((NUMVERTEXNORMALS + 7) / 8)
+
+typedef struct skyprobe_s
+{
+    struct skyprobe_s* volatile next;
+    int             cell[3];
+    bool            valid;                                 // origin is not inside solid or sky
+    byte            sky[SKYPROBE_MASKBYTES];               // bit set when that direction reaches the sky
+} skyprobe_t;
+
+static skyprobe_t* volatile s_skyprobes[SKYPROBE_HASHES];
+static volatile long s_skyprobecount = 0;
+static volatile long s_skyraystraced = 0;
+static volatile long s_skyraysskipped = 0;
+
+static unsigned SkyProbeHash(const int x, const int y, const int z)
+{
+    return ((unsigned)x * 73856093u ^ (unsigned)y * 19349663u ^ (unsigned)z * 83492791u) & (SKYPROBE_HASHES - 1);
+}
+
+static const skyprobe_t* GetSkyProbe(const int x, const int y, const int z)
+{
+    const unsigned  hash = SkyProbeHash(x, y, z);
+    skyprobe_t*     probe;
+    skyprobe_t*     other;
+    const dleaf_t*  leaf;
+    vec3_t          origin;
+    vec3_t          delta;
+    int             j;
+
+    // probes are never changed once linked in, so the chains can be walked without the lock
+    for (probe = s_skyprobes[hash]; probe; probe = probe->next)
+    {
+        if (probe->cell[0] == x && probe->cell[1] == y && probe->cell[2] == z)
+        {
+            return probe;
+        }
+    }
+
+    probe = (skyprobe_t*)calloc(1, sizeof(skyprobe_t));
+    hlassume(probe != NULL, assume_NoMemory);
+    probe->cell[0] = x;
+    probe->cell[1] = y;
+    probe->cell[2] = z;
+
+    origin[0] = x * SKYPROBE_GRID;
+    origin[1] = y * SKYPROBE_GRID;
+    origin[2] = z * SKYPROBE_GRID;
+    leaf = PointInLeaf(origin);
+    probe->valid = (leaf != g_dleafs && leaf->contents != CONTENTS_SOLID && leaf->contents != CONTENTS_SKY);
+    for (j = 0; j < NUMVERTEXNORMALS && probe->valid; j++)
+    {
+        VectorScale(r_avertexnormals[j], -BOGUS_RANGE, delta);
+        VectorAdd(origin, delta, delta);
+        if (TestLine(origin, delta) == CONTENTS_SKY)
+        {
+            probe->sky[j >> 3] |= 1 << (j & 7);
+        }
+    }
+
+    ThreadLock();
+    // another thread may have built the same probe in the meantime
+    for (other = s_skyprobes[hash]; other; other = other->next)
+    {
+        if (other->cell[0] == x && other->cell[1] == y && other->cell[2] == z)
+        {
+            ThreadUnlock();
+            free(probe);
+            return other;
+        }
+    }
+    probe->next = s_skyprobes[hash];
+    s_skyprobes[hash] = probe;
+    ThreadUnlock();
+
+    ThreadAtomicAdd(&s_skyprobecount, 1);
+    return probe;
+}
+
+// allsky: directions every valid surrounding probe sees the sky in, anysky: directions at least
+// one does. Returns the number of valid probes, the masks mean nothing when there are none
+static int      GetSkyProbeMasks(const vec3_t pos, byte* allsky, byte* anysky)
+{
+    const skyprobe_t* probe;
+    int             base[3];
+    int             corner;
+    int             numvalid = 0;
+    int             k;
+
+    for (k = 0; k < 3; k++)
+    {
+        base[k] = (int)floor(pos[k] / SKYPROBE_GRID);
+    }
+
+    memset(allsky, 0xFF, SKYPROBE_MASKBYTES);
+    memset(anysky, 0, SKYPROBE_MASKBYTES);
+    for (corner = 0; corner < 8; corner++)
+    {
+        probe = GetSkyProbe(base[0] + (corner & 1), base[1] + ((corner >> 1) & 1), base[2] + ((corner >> 2) & 1));
+        if (!probe->valid)
+        {
+            continue;
+        }
+        for (k = 0; k < SKYPROBE_MASKBYTES; k++)
+        {
+            allsky[k] &= probe->sky[k];
+            anysky[k] |= probe->sky[k];
+        }
+        numvalid++;
+    }
+    return numvalid;
+}
+
+// =====================================================================================
+//  FreeSkyProbes
+// =====================================================================================
+void            FreeSkyProbes()
+{
+    skyprobe_t*     probe;
+    skyprobe_t*     next;
+    int             i;
+
+    if (s_skyraystraced || s_skyraysskipped)
+    {
+        Verbose("%li sky probes, %li indirect sun rays traced, %li resolved by probes\n",
+                s_skyprobecount, s_skyraystraced, s_skyraysskipped);
+    }
+
+    for (i = 0; i < SKYPROBE_HASHES; i++)
+    {
+        for (probe = s_skyprobes[i]; probe; probe = next)
+        {
+            next = probe->next;
+            free(probe);
+        }
+        s_skyprobes[i] = NULL;
+    }
+    s_skyprobecount = s_skyraystraced = s_skyraysskipped = 0;
+}
+
+// occlusion results from the first GatherSampleLight pass, in light order,
+// so the bump pass does not trace the same rays a second time
+#define MAX_SAMPLE_LIGHTVIS 1024
+
+typedef struct
+{
+    const directlight_t* light;
+    bool            visible;
+} lightvis_t;
+
+static void RecordLightVis(lightvis_t* vis, int* numvis, const directlight_t* l, const bool visible)
+{
+    if (*numvis < MAX_SAMPLE_LIGHTVIS)
+    {
+        vis[*numvis].light = l;
+        vis[*numvis].visible = visible;
+        (*numvis)++;
+    }
+}
+
+// returns 1/0 for a light tested by the first pass, -1 if it was never tested
+static int FindLightVis(const lightvis_t* vis, const int numvis, int* cursor, const directlight_t* l)
+{
+    int             i;
+
+    // both passes walk the lights in the same order, except -simd records
+    // the batched lights after the sky light of their leaf
+    for (i = *cursor; i < numvis; i++)
+    {
+        if (vis[i].light == l)
+        {
+            *cursor = i + 1;
+            return vis[i].visible;
+        }
+    }
+    for (i = 0; i < *cursor && i < numvis; i++)
+    {
+        if (vis[i].light == l)
+        {
+            *cursor = i + 1;
+            return vis[i].visible;
+        }
+    }
+    return -1;
+}
+
+// -simd: lights that got past the batched culling, waiting to be traced
+#define MAX_LIGHT_SURVIVORS 256
+
+typedef struct
+{
+    int             count;
+    directlight_t*  lights[MAX_LIGHT_SURVIVORS];
+    vec_t           ratio[MAX_LIGHT_SURVIVORS];
+    bool            visible[MAX_LIGHT_SURVIVORS];
+#ifdef HLRAD_HULLU
+    vec3_t          transparency[MAX_LIGHT_SURVIVORS];
+#endif
+    double          phasetime[LIGHTPHASE_COUNT];
+}
+lightsurvivors_t;
+
+// =====================================================================================
+//  CullLightLanes
+//      falloff and cone tests for LIGHTBATCH_WIDTH lights of a batch at once,
+//      tnormal is the sample normal moved into world space by the light matrix
+// =====================================================================================
+static void     CullLightLanes(const lightbatch_t* batch, const int first, const vec3_t pos, const vec3_t tnormal, lightsurvivors_t* survivors)
+{
+    vec_t           ratio[LIGHTBATCH_WIDTH];
+    vec_t           dx, dy, dz;
+    vec_t           dist, scale;
+    vec_t           dot, dot2;
+    vec_t           denominator, cone;
+    vec3_t          add;
+    directlight_t*  l;
+    int             n, k;
+
+    // no branches in here, every lane runs the same code
+    for (k = 0; k < LIGHTBATCH_WIDTH; k++)
+    {
+        n = first + k;
+        dx = batch->origin[0][n] - pos[0];
+        dy = batch->origin[1][n] - pos[1];
+        dz = batch->origin[2][n] - pos[2];
+        dist = sqrt(dx * dx + dy * dy + dz * dz);
+        scale = (dist > 0) ? 1 / dist : 0;
+
+        dot = (dx * tnormal[0] + dy * tnormal[1] + dz * tnormal[2]) * scale;
+        dot2 = -(dx * batch->normal[0][n] + dy * batch->normal[1][n] + dz * batch->normal[2][n]) * scale;
+
+        dist = (dist < 1) ? 1 : dist;
+        denominator = dist * batch->fade[n] * (1 + batch->square[n] * (dist - 1));
+        cone = (dot2 <= batch->stopdot[n]) ? (dot2 - batch->cullcos[n]) * batch->conescale[n] : 1;
+
+        ratio[k] = dot * (1 + batch->usedot2[n] * (dot2 - 1)) * cone / denominator;
+        ratio[k] = (dot > ON_EPSILON / 10 && dot2 > batch->cullcos[n]) ? ratio[k] : 0;
+    }
+
+    for (k = 0; k < LIGHTBATCH_WIDTH; k++)
+    {
+        if (ratio[k] == 0)
+        {
+            continue;
+        }
+
+        l = batch->lights[first + k];
+        VectorScale(l->intensity, ratio[k], add);
+        if (!VectorMaximum(add))
+        {
+            continue;
+        }
+
+        survivors->lights[survivors->count] = l;
+        survivors->ratio[survivors->count] = ratio[k];
+        survivors->count++;
+    }
+}
+
+// =====================================================================================
+//  FlushLightSurvivors
+//      traces every survivor first, then adds the visible ones to the sample
+// =====================================================================================
+static void     FlushLightSurvivors(lightsurvivors_t* survivors, const vec3_t pos, float* lightmatrix,
+                                    vec3_t* sample, vec3_t lightdir, int* skiprenderer,
+                                    lightvis_t* lightvis, int* numlightvis)
+{
+    directlight_t*  l;
+    vec3_t          add;
+    vec3_t          delta;
+    vec3_t          lighttransformed;
+    double          start, traced;
+    int             k;
+
+    start = I_FloatTime();
+
+    for (k = 0; k < survivors->count; k++)
+    {
+        survivors->visible[k] = TestLine(pos, survivors->lights[k]->origin) == CONTENTS_EMPTY;
+    }
+
+    for (k = 0; k < survivors->count; k++)
+    {
+        if (!survivors->visible[k])
+        {
+            continue;
+        }
+#ifdef HLRAD_HULLU
+        VectorFill(survivors->transparency[k], 1.0);
+        survivors->visible[k] = !TestSegmentAgainstOpaqueList(pos, survivors->lights[k]->origin, survivors->transparency[k]);
+#else
+        survivors->visible[k] = !TestSegmentAgainstOpaqueList(pos, survivors->lights[k]->origin);
+#endif
+    }
+
+    traced = I_FloatTime();
+    survivors->phasetime[LIGHTPHASE_OCCLUSION] += traced - start;
+
+    for (k = 0; k < survivors->count; k++)
+    {
+        l = survivors->lights[k];
+        RecordLightVis(lightvis, numlightvis, l, survivors->visible[k]);
+        if (!survivors->visible[k])
+        {
+            continue;                                      // occluded
+        }
+
+        VectorScale(l->intensity, survivors->ratio[k], add);
+#ifdef HLRAD_HULLU
+        VectorMultiply(add, survivors->transparency[k], add);
+#endif
+
+        // buz: delta must contain direction to light
+        VectorSubtract(l->origin, pos, delta);
+        VectorNormalize(delta);
+        VTransform(delta, lightmatrix, lighttransformed);
+
+        if (!(l->flags & LIGHTFLAG_NOT_RENDERER))
+        {
+            VectorScale(lighttransformed, VectorMaximum(add), delta);
+            VectorAdd(delta, lightdir, lightdir);
+        }
+        else
+        {
+            *skiprenderer = 1;
+        }
+
+        if (!(l->flags & LIGHTFLAG_NOT_NORMAL))
+        {
+            VectorAdd(sample[0], add, sample[0]);
+        }
+    }
+
+    survivors->phasetime[LIGHTPHASE_SHADE] += I_FloatTime() - traced;
+    survivors->count = 0;
+}
+
 static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3_t normal, vec3_t* sample, byte* styles, float *lightmatrix)
 {
     int             i;
@@ -1291,6 +1838,30 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 
 	int skiprenderer = 0; // will be true if we have here some lights with LIGHTFLAG_NOT_RENDERER
 
+    lightvis_t      lightvis[MAX_SAMPLE_LIGHTVIS];
+    int             numlightvis = 0;
+    int             lightviscursor = 0;
+    int             visible;
+
+    lightsurvivors_t survivors;
+    lightbatch_t*   batch;
+    vec3_t          tnormal;
+    double          start, end;
+    int             j;
+
+    start = I_FloatTime();
+    survivors.count = 0;
+    memset(survivors.phasetime, 0, sizeof(survivors.phasetime));
+
+    if (g_simd)
+    {
+        // DotProduct(VTransform(delta), normal) == DotProduct(delta, tnormal)
+        for (j = 0; j < 3; j++)
+        {
+            tnormal[j] = lightmatrix[j * 3] * normal[0] + lightmatrix[j * 3 + 1] * normal[1] + lightmatrix[j * 3 + 2] * normal[2];
+        }
+    }
+
     for (i = 1; i < g_numleafs; i++)
     {
         l = directlights[i];
@@ -1298,8 +1869,26 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
         {
             if (((l->type == emit_skylight) && (g_sky_lighting_fix)) || (pvs[(i - 1) >> 3] & (1 << ((i - 1) & 7))))
             {
+                if (g_simd)
+                {
+                    batch = &s_lightbatches[i];
+                    for (j = 0; j < batch->numlights; j += LIGHTBATCH_WIDTH)
+                    {
+                        if (survivors.count + LIGHTBATCH_WIDTH > MAX_LIGHT_SURVIVORS)
+                        {
+                            FlushLightSurvivors(&survivors, pos, lightmatrix, sample, lightdir, &skiprenderer, lightvis, &numlightvis);
+                        }
+                        CullLightLanes(batch, j, pos, tnormal, &survivors);
+                    }
+                }
+
                 for (; l; l = l->next)
                 {
+                    if (g_simd && l->type != emit_skylight)
+                    {
+                        continue;                          // culled in the batch above
+                    }
+
                     // skylights work fundamentally differently than normal lights
                     if (l->type == emit_skylight)
                     {
@@ -1326,6 +1915,7 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
                         VectorAdd(pos, delta, delta);
                         if (TestLine(pos, delta) != CONTENTS_SKY)
                         {
+                            RecordLightVis(lightvis, &numlightvis, l, false);
                             continue;                      // occluded
                         }
 
@@ -1336,8 +1926,10 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 			            if (TestSegmentAgainstOpaqueList(pos, delta))
 #endif                 
                         {
+                            RecordLightVis(lightvis, &numlightvis, l, false);
                             continue;
                         }
+                        RecordLightVis(lightvis, &numlightvis, l, true);
 
                         VectorScale(l->intensity, dot, add);
 					//	VectorScale(l->normal, -1, delta); // buz - put in delta direction to light
@@ -1455,7 +2047,10 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 #endif 
 
                         if (l->type != emit_skylight && TestLine(pos, l->origin) != CONTENTS_EMPTY)
+                        {
+                            RecordLightVis(lightvis, &numlightvis, l, false);
 							continue;                      // occluded
+                        }
 
                         if (l->type != emit_skylight)
                         {                                  // Don't test from light_environment entities to face, the special sky code occludes correctly
@@ -1465,8 +2060,10 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
                             if (TestSegmentAgainstOpaqueList(pos, l->origin))
 #endif
                             {
+                                RecordLightVis(lightvis, &numlightvis, l, false);
                                 continue;
                             }
+                            RecordLightVis(lightvis, &numlightvis, l, true);
 #ifdef HLRAD_HULLU
                         VectorMultiply(add,transparency,add);
 #endif
@@ -1493,6 +2090,20 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
         }
     }
 
+    if (survivors.count)
+    {
+        FlushLightSurvivors(&survivors, pos, lightmatrix, sample, lightdir, &skiprenderer, lightvis, &numlightvis);
+    }
+
+    end = I_FloatTime();
+    survivors.phasetime[LIGHTPHASE_DIRECT] = end - start;
+    if (g_simd)
+    {
+        // whatever the traces and shading did not take went into culling
+        survivors.phasetime[LIGHTPHASE_CULL] = survivors.phasetime[LIGHTPHASE_DIRECT]
+            - survivors.phasetime[LIGHTPHASE_OCCLUSION] - survivors.phasetime[LIGHTPHASE_SHADE];
+    }
+
 //	Log("sample: %f, %f, %f\n", sample[0][0], sample[0][1], sample[0][2]);
 
 //============== buz: make second pass, create special lightmaps ==========
@@ -1542,19 +2153,22 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 							// search back to see if we can hit a sky brush
 							VectorScale(l->normal, -BOGUS_RANGE, delta);
 							VectorAdd(pos, delta, delta);
-							if (TestLine(pos, delta) != CONTENTS_SKY)
-							{
-								continue;                      // occluded
-							}
-
 #ifdef HLRAD_HULLU
 							vec3_t transparency = {1.0,1.0,1.0};
-                            					if (TestSegmentAgainstOpaqueList(pos, delta, transparency))
+#endif
+							visible = FindLightVis(lightvis, numlightvis, &lightviscursor, l);
+							if (visible == -1)
+							{
+								visible = TestLine(pos, delta) == CONTENTS_SKY
+#ifdef HLRAD_HULLU
+									&& !TestSegmentAgainstOpaqueList(pos, delta, transparency);
 #else
-                            					if (TestSegmentAgainstOpaqueList(pos, delta))
+									&& !TestSegmentAgainstOpaqueList(pos, delta);
 #endif
+							}
+							if (!visible)
 							{
-								continue;
+								continue;                      // occluded
 							}
 
 							// buz
@@ -1691,19 +2305,24 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 						// buz: here adding collected light to sample
 						if (VectorMaximum(add))
 						{
-							if (l->type != emit_skylight && TestLine(pos, l->origin) != CONTENTS_EMPTY)
-								continue;                      // occluded
-
 							if (l->type != emit_skylight)
 							{                                  // Don't test from light_environment entities to face, the special sky code occludes correctly
+								visible = FindLightVis(lightvis, numlightvis, &lightviscursor, l);
+								if (visible == -1)
+								{
 #ifdef HLRAD_HULLU
-                 	    						vec3_t transparency = {1.0,1.0,1.0};
-								if (TestSegmentAgainstOpaqueList(pos, l->origin, transparency))
+                 	    							vec3_t transparency = {1.0,1.0,1.0};
+#endif
+									visible = TestLine(pos, l->origin) == CONTENTS_EMPTY
+#ifdef HLRAD_HULLU
+										&& !TestSegmentAgainstOpaqueList(pos, l->origin, transparency);
 #else
-								if (TestSegmentAgainstOpaqueList(pos, l->origin))
+										&& !TestSegmentAgainstOpaqueList(pos, l->origin);
 #endif
+								}
+								if (!visible)
 								{
-									continue;
+									continue;                      // occluded
 								}
 							}
 							
@@ -1720,6 +2339,12 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
 	}
 //=========================== buz: end second pass ========================
 
+    survivors.phasetime[LIGHTPHASE_BUMP] = I_FloatTime() - end;
+    for (j = 0; j < LIGHTPHASE_COUNT; j++)
+    {
+        s_lightphasetime[GetThreadNum()][j] += survivors.phasetime[j];
+    }
+
 	VectorCopy(lightdir, sample[BUMP_LIGHTVECS_MAP]); // buz
 
     if (sky_used && g_indirect_sun != 0.0)
@@ -1727,6 +2352,11 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
         vec3_t          total;
         int             j;
 		vec3_t          sky_intensity;
+        byte            allsky[SKYPROBE_MASKBYTES];
+        byte            anysky[SKYPROBE_MASKBYTES];
+        long            traced = 0;
+        long            skipped = 0;
+        bool            useprobes = false;
 
 		// -----------------------------------------------------------------------------------
 		// Changes by Adam Foster - afoster@compsoc.man.ac.uk
@@ -1740,6 +2370,11 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
         // AJM: It DOES actually work. Havent you ever heard of beta testing....
 		// -----------------------------------------------------------------------------------
 
+        if (g_fastsky)
+        {
+            useprobes = GetSkyProbeMasks(pos, allsky, anysky) > 0;
+        }
+
         total[0] = total[1] = total[2] = 0.0;
         for (j = 0; j < NUMVERTEXNORMALS; j++)
         {
@@ -1750,17 +2385,35 @@ static int GatherSampleLight(const vec3_t pos, const byte* const pvs, const vec3
                 continue;
             }
 
-            // search back to see if we can hit a sky brush
-            VectorScale(r_avertexnormals[j], -BOGUS_RANGE, delta);
-            VectorAdd(pos, delta, delta);
-            if (TestLine(pos, delta) != CONTENTS_SKY)
+            if (useprobes && (allsky[j >> 3] & (1 << (j & 7))))
             {
-                continue;                                  // occluded
+                skipped++;                                 // every probe around sees the sky here
+            }
+            else if (useprobes && !(anysky[j >> 3] & (1 << (j & 7))))
+            {
+                skipped++;
+                continue;                                  // no probe around sees the sky here
+            }
+            else
+            {
+                // search back to see if we can hit a sky brush
+                VectorScale(r_avertexnormals[j], -BOGUS_RANGE, delta);
+                VectorAdd(pos, delta, delta);
+                traced++;
+                if (TestLine(pos, delta) != CONTENTS_SKY)
+                {
+                    continue;                              // occluded
+                }
             }
 
             VectorScale(sky_intensity, dot, add);
             VectorAdd(total, add, total);
         }
+        if (g_fastsky)
+        {
+            ThreadAtomicAdd(&s_skyraystraced, traced);
+            ThreadAtomicAdd(&s_skyraysskipped, skipped);
+        }
         if (VectorMaximum(total) > 0)
         {
             for (style_index = 0; style_index < MAXLIGHTMAPS; style_index++)
@@ -1586,6 +1586,7 @@ static void     RadWorld()
 
     // free up the direct lights now that we have facelights
     DeleteDirectLights();
+    FreeSkyProbes();
 
     if (g_numbounce > 0)
     {
@@ -1637,6 +1638,8 @@ static void     Usage()
     Log("    -scale #        : Set global light scaling value\n");
     Log("    -gamma #        : Set global gamma value\n\n");
     Log("    -sky #          : Set ambient sunlight contribution in the shade outside\n");
+    Log("    -fastsky        : Resolve ambient sunlight against a coarse probe grid first\n");
+    Log("    -simd           : Cull direct lights in batches of 8, then trace the survivors\n");
     Log("    -lights file    : Manually specify a lights.rad file to use\n");
     Log("    -noskyfix       : Disable light_environment being global\n");
     Log("    -incremental    : Use or create an incremental transfer list file\n\n");
@@ -1832,6 +1835,8 @@ static void     Settings()
     Log("\n");
     Log("opaque entities      [ %17s ] [ %17s ]\n", g_allow_opaques ? "on" : "off", DEFAULT_ALLOW_OPAQUES ? "on" : "off");
     Log("sky lighting fix     [ %17s ] [ %17s ]\n", g_sky_lighting_fix ? "on" : "off", DEFAULT_SKY_LIGHTING_FIX ? "on" : "off");
+    Log("fast sky             [ %17s ] [ %17s ]\n", g_fastsky ? "on" : "off", DEFAULT_FASTSKY ? "on" : "off");
+    Log("batched lights       [ %17s ] [ %17s ]\n", g_simd ? "on" : "off", DEFAULT_SIMD ? "on" : "off");
     Log("incremental          [ %17s ] [ %17s ]\n", g_incremental ? "on" : "off", DEFAULT_INCREMENTAL ? "on" : "off");
     Log("dump                 [ %17s ] [ %17s ]\n", g_dumppatches ? "on" : "off", DEFAULT_DUMPPATCHES ? "on" : "off");
 
@@ -2331,6 +2336,14 @@ int             main(const int argc, char** argv)
         {
             g_sky_lighting_fix = false;
         }
+        else if (!strcasecmp(argv[i], "-fastsky"))
+        {
+            g_fastsky = true;
+        }
+        else if (!strcasecmp(argv[i], "-simd"))
+        {
+            g_simd = true;
+        }
         else if (!strcasecmp(argv[i], "-incremental"))
         {
             g_incremental = true;
@@ -2646,6 +2659,8 @@ int             main(const int argc, char** argv)
 
     WriteBSPFile(g_source);
 
+    WindingPoolStats();
+
     end = I_FloatTime();
     LogTimeElapsed(end - start);
     // END RAD
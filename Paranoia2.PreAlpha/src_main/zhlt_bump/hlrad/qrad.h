@@ -80,6 +80,8 @@
 #define DEFAULT_INDIRECT_SUN        1.0
 #define DEFAULT_EXTRA               false
 #define DEFAULT_SKY_LIGHTING_FIX    true
+#define DEFAULT_FASTSKY             false
+#define DEFAULT_SIMD                false
 #define DEFAULT_CIRCUS              false
 #define DEFAULT_CORING              1.0
 #define DEFAULT_SUBDIVIDE           true
@@ -397,6 +399,8 @@ extern int      g_falloff;
 extern bool     g_incremental;
 extern bool     g_circus;
 extern bool     g_sky_lighting_fix;
+extern bool     g_fastsky;
+extern bool     g_simd;
 extern vec_t    g_chop;    // Chop value for normal textures
 extern vec_t    g_texchop; // Chop value for texture lights
 extern opaqueList_t* g_opaque_face_list;
@@ -440,6 +444,7 @@ extern int      TestLine(const vec3_t start, const vec3_t stop);
 extern int      TestLine_r(int node, const vec3_t start, const vec3_t stop);
 extern void     CreateDirectLights();
 extern void     DeleteDirectLights();
+extern void     FreeSkyProbes();
 extern void     GetPhongNormal(int facenum, vec3_t spot, vec3_t phongnormal);
 
 #ifdef HLRAD_HULLU
@@ -13,15 +13,46 @@ static transparency_t *s_transparency_list=NULL;
 static unsigned long s_transparency_count=0;
 static unsigned long s_max_transparency_count=0;
 
+static int CDECL CompareTransparency(const void* a, const void* b)
+{
+	const transparency_t* t1 = (const transparency_t*)a;
+	const transparency_t* t2 = (const transparency_t*)b;
+
+	if(t1->x != t2->x)
+		return t1->x < t2->x ? -1 : 1;
+	if(t1->y != t2->y)
+		return t1->y < t2->y ? -1 : 1;
+	return 0;
+}
+
+// the list is filled in any order while the vismatrix is built, then sorted once
+// so MakeScales can binary search it instead of scanning it for every patch pair
+static void SortTransparencyList()
+{
+	if(s_transparency_count > 1)
+		qsort(s_transparency_list, s_transparency_count, sizeof(transparency_t), CompareTransparency);
+}
+
 static void FindOpacity(const unsigned p1, const unsigned p2, vec3_t &out)
 {
-	for(unsigned long i = 0; i < s_transparency_count; i++)
+	unsigned long lo = 0;
+	unsigned long hi = s_transparency_count;
+
+	while(lo < hi)
+	{
+		const unsigned long mid = (lo + hi) / 2;
+		const transparency_t* t = &s_transparency_list[mid];
+
+		if(t->x < p1 || (t->x == p1 && t->y < p2))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if(lo < s_transparency_count && s_transparency_list[lo].x == p1 && s_transparency_list[lo].y == p2)
 	{
-		if(s_transparency_list[i].x==p1 && s_transparency_list[i].y==p2)
-		{
-			VectorCopy(s_transparency_list[i].transparency, out);
-			return;
-		}
+		VectorCopy(s_transparency_list[lo].transparency, out);
+		return;
 	}
 	VectorFill(out, 1.0);
 }
@@ -294,6 +325,7 @@ static void     TestPatchToFace(const unsigned patchnum, const int facenum, cons
                     // transparency face fix table
                     if(g_customshadow_with_bouncelight && fabs(VectorAvg(transparency) - 1.0) < 0.001)
                     {
+                    	ThreadLock();
                     	while(s_transparency_count>=s_max_transparency_count)
                     	{
                     	    //new size
@@ -313,6 +345,7 @@ static void     TestPatchToFace(const unsigned patchnum, const int facenum, cons
                     	s_transparency_list[s_transparency_count].x = patchnum;
                     	
                     	s_transparency_count++;
+                    	ThreadUnlock();
                     }
 #endif
                     SetVisBit(m, patchnum);
@@ -530,6 +563,8 @@ void            MakeScalesSparseVismatrix()
         g_CheckVisBit = CheckVisBitSparse;
 
 #ifdef HLRAD_HULLU
+        SortTransparencyList();
+
         if((s_max_transparency_count*sizeof(transparency_t))>=(1024 * 1024))
         	Log("%-20s: %5.1f megs\n", "custom shadow array", (s_max_transparency_count*sizeof(transparency_t)) / (1024 * 1024.0));
         else if(s_transparency_count)
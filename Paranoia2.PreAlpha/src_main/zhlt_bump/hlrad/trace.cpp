@@ -1,9 +1,13 @@
 #include "cmdlib.h"
 #include "mathlib.h"
 #include "bspfile.h"
+#include "log.h"
 
 // #define      ON_EPSILON      0.001
 
+// deepest node chain TestLine_r can follow without recursion
+#define MAX_TNODE_STACK 256
+
 typedef struct tnode_s
 {
     planetypes      type;
@@ -13,8 +17,15 @@ typedef struct tnode_s
     int             pad;
 } tnode_t;
 
+typedef struct tstack_s
+{
+    int             node;
+    vec3_t          start;
+    vec3_t          stop;
+} tstack_t;
+
 static tnode_t* tnodes;
-static tnode_t* tnode_p;
+static int      tnode_depth;
 
 /*
  * ==============
@@ -23,15 +34,12 @@ static tnode_t* tnode_p;
  * Converts the disk node structure into the efficient tracing structure
  * ==============
  */
-static void     MakeTnode(const int nodenum)
+static void     MakeTnode(tnode_t* t, const int nodenum, int* queue, int* queue_tail)
 {
-    tnode_t*        t;
     dplane_t*       plane;
     int             i;
     dnode_t*        node;
 
-    t = tnode_p++;
-
     node = g_dnodes + nodenum;
     plane = g_dplanes + node->planenum;
 
@@ -45,11 +53,10 @@ static void     MakeTnode(const int nodenum)
             t->children[i] = g_dleafs[-node->children[i] - 1].contents;
         else
         {
-            t->children[i] = tnode_p - tnodes;
-            MakeTnode(node->children[i]);
+            t->children[i] = *queue_tail;
+            queue[(*queue_tail)++] = node->children[i];
         }
     }
-
 }
 
 /*
@@ -57,10 +64,18 @@ static void     MakeTnode(const int nodenum)
  * MakeTnodes
  * 
  * Loads the node structure out of a .bsp file to be used for light occlusion
+ * The nodes are laid out breadth first, so the upper levels of the tree that
+ * every trace walks through share the same few cache lines
  * =============
  */
 void            MakeTnodes(dmodel_t* /*bm*/)
 {
+    int*            queue;
+    int*            depth;
+    int             queue_head;
+    int             queue_tail;
+    int             i;
+
     // 32 byte align the structs
     tnodes = (tnode_t*)calloc((g_numnodes + 1), sizeof(tnode_t));
 
@@ -69,70 +84,123 @@ void            MakeTnodes(dmodel_t* /*bm*/)
 #else
     tnodes = (tnode_t*)(((int)tnodes + 31) & ~31);
 #endif
-    tnode_p = tnodes;
 
-    MakeTnode(0);
+    // queue[i] is the disk node that becomes tnodes[i]
+    queue = (int*)calloc(g_numnodes + 1, sizeof(int));
+    depth = (int*)calloc(g_numnodes + 1, sizeof(int));
+    queue_head = 0;
+    queue_tail = 1;
+    queue[0] = 0;
+    tnode_depth = 0;
+
+    while (queue_head < queue_tail)
+    {
+        const int first_child = queue_tail;
+
+        MakeTnode(&tnodes[queue_head], queue[queue_head], queue, &queue_tail);
+        for (i = first_child; i < queue_tail; i++)
+        {
+            depth[i] = depth[queue_head] + 1;
+        }
+        tnode_depth = max(tnode_depth, depth[queue_head] + 1);
+        queue_head++;
+    }
+
+    free(queue);
+    free(depth);
+
+    if (tnode_depth > MAX_TNODE_STACK)
+    {
+        Error("MakeTnodes: node tree depth %d exceeds MAX_TNODE_STACK (%d)", tnode_depth, MAX_TNODE_STACK);
+    }
 }
 
 //==========================================================
 
-int             TestLine_r(const int node, const vec3_t start, const vec3_t stop)
+int             TestLine_r(const int head, const vec3_t start, const vec3_t stop)
 {
-    tnode_t*        tnode;
+    tstack_t        stack[MAX_TNODE_STACK];
+    tstack_t*       sp;
+    const tnode_t*  tnode;
     float           front, back;
-    vec3_t          mid;
     float           frac;
+    int             node;
     int             side;
-    int             r;
-
-	if (   (node == CONTENTS_SOLID) 
-        || (node == CONTENTS_SKY  ) 
-      /*|| (node == CONTENTS_NULL ) */
-       )
-		return node;
+    vec3_t          p1, p2;
 
-    if (node < 0)
-        return CONTENTS_EMPTY; 
+    sp = stack;
+    node = head;
+    VectorCopy(start, p1);
+    VectorCopy(stop, p2);
 
-    tnode = &tnodes[node];
-    switch (tnode->type)
+    for (;;)
     {
-    case plane_x:
-        front = start[0] - tnode->dist;
-        back = stop[0] - tnode->dist;
-        break;
-    case plane_y:
-        front = start[1] - tnode->dist;
-        back = stop[1] - tnode->dist;
-        break;
-    case plane_z:
-        front = start[2] - tnode->dist;
-        back = stop[2] - tnode->dist;
-        break;
-    default:
-        front = (start[0] * tnode->normal[0] + start[1] * tnode->normal[1] + start[2] * tnode->normal[2]) - tnode->dist;
-        back = (stop[0] * tnode->normal[0] + stop[1] * tnode->normal[1] + stop[2] * tnode->normal[2]) - tnode->dist;
-        break;
-    }
-
-    if (front >= -ON_EPSILON && back >= -ON_EPSILON)
-        return TestLine_r(tnode->children[0], start, stop);
-
-    if (front < ON_EPSILON && back < ON_EPSILON)
-        return TestLine_r(tnode->children[1], start, stop);
-
-    side = front < 0;
+        // walk down to a leaf, keeping the far half of every split segment
+        while (node >= 0)
+        {
+            tnode = &tnodes[node];
+            switch (tnode->type)
+            {
+            case plane_x:
+                front = p1[0] - tnode->dist;
+                back = p2[0] - tnode->dist;
+                break;
+            case plane_y:
+                front = p1[1] - tnode->dist;
+                back = p2[1] - tnode->dist;
+                break;
+            case plane_z:
+                front = p1[2] - tnode->dist;
+                back = p2[2] - tnode->dist;
+                break;
+            default:
+                front = (p1[0] * tnode->normal[0] + p1[1] * tnode->normal[1] + p1[2] * tnode->normal[2]) - tnode->dist;
+                back = (p2[0] * tnode->normal[0] + p2[1] * tnode->normal[1] + p2[2] * tnode->normal[2]) - tnode->dist;
+                break;
+            }
+
+            if (front >= -ON_EPSILON && back >= -ON_EPSILON)
+            {
+                node = tnode->children[0];
+                continue;
+            }
+
+            if (front < ON_EPSILON && back < ON_EPSILON)
+            {
+                node = tnode->children[1];
+                continue;
+            }
+
+            side = front < 0;
+
+            frac = front / (front - back);
+
+            // the far side is tested from the split point once the near side came out empty
+            sp->node = tnode->children[!side];
+            sp->start[0] = p1[0] + (p2[0] - p1[0]) * frac;
+            sp->start[1] = p1[1] + (p2[1] - p1[1]) * frac;
+            sp->start[2] = p1[2] + (p2[2] - p1[2]) * frac;
+            VectorCopy(p2, sp->stop);
+            VectorCopy(sp->start, p2);
+            sp++;
+
+            node = tnode->children[side];
+        }
 
-    frac = front / (front - back);
+        if (   (node == CONTENTS_SOLID) 
+            || (node == CONTENTS_SKY  ) 
+          /*|| (node == CONTENTS_NULL ) */
+           )
+            return node;
 
-    mid[0] = start[0] + (stop[0] - start[0]) * frac;
-    mid[1] = start[1] + (stop[1] - start[1]) * frac;
-    mid[2] = start[2] + (stop[2] - start[2]) * frac;
+        if (sp == stack)
+            return CONTENTS_EMPTY;
 
-    r = TestLine_r(tnode->children[side], start, mid);
-    if (r != CONTENTS_EMPTY)
-        return r;
-    return TestLine_r(tnode->children[!side], mid, stop);
+        sp--;
+        node = sp->node;
+        VectorCopy(sp->start, p1);
+        VectorCopy(sp->stop, p2);
+    }
 }
 
 int             TestLine(const vec3_t start, const vec3_t stop)
@@ -10,6 +10,106 @@
 #include <sys/stat.h>
 #endif
 
+// Transfer file layout:
+//   transferheader_t
+//   numpatches * unsigned      per patch geometry key
+//   per patch: iIndex, tIndex[iIndex], iData, tData[iData]
+//
+// The keys cover everything MakeScales looks at (patch placement, the
+// bsp tree used for visibility, the pvs and the opaque face list), so a
+// relight after a light or plain entity edit reuses the file, while any
+// geometry change rebuilds it.  Old headerless files are rejected.
+
+#define TRANSFERFILE_IDENT      (('S'<<24)+('N'<<16)+('R'<<8)+'T') // little-endian "TRNS"
+#define TRANSFERFILE_VERSION    2
+
+typedef struct
+{
+    int             ident;
+    int             version;
+    long            numpatches;
+    unsigned        worldkey;
+    int             datasize;                              // sizeof one transfer_data_t or rgb_transfer_data_t
+} transferheader_t;
+
+static unsigned TransferChecksum(unsigned checksum, const void* const buffer, int bytes)
+{
+    const byte*     buf = (const byte*)buffer;
+
+    while (bytes--)
+    {
+        checksum = rotl(checksum, 4) ^ (*buf);
+        buf++;
+    }
+
+    return checksum;
+}
+
+static int      TransferDataSize()
+{
+#ifdef HLRAD_HULLU
+    if (g_rgb_transfers)
+    {
+        return sizeof(rgb_transfer_data_t);
+    }
+#endif
+    return sizeof(transfer_data_t);
+}
+
+/*
+ * =============
+ * TransferWorldKey
+ * 
+ * Everything outside of the patches themselves that affects the transfers
+ * =============
+ */
+static unsigned TransferWorldKey()
+{
+    unsigned        key = 0;
+    unsigned        i;
+
+    key = TransferChecksum(key, &g_dnodes_checksum, sizeof(g_dnodes_checksum));
+    key = TransferChecksum(key, &g_dplanes_checksum, sizeof(g_dplanes_checksum));
+    key = TransferChecksum(key, &g_dleafs_checksum, sizeof(g_dleafs_checksum));
+    key = TransferChecksum(key, &g_dvisdata_checksum, sizeof(g_dvisdata_checksum));
+
+    // only the face geometry, styles and lightofs are written by hlrad itself
+    for (i = 0; i < (unsigned)g_numfaces; i++)
+    {
+        const dface_t*  f = &g_dfaces[i];
+
+        key = TransferChecksum(key, &f->planenum, sizeof(f->planenum));
+        key = TransferChecksum(key, &f->side, sizeof(f->side));
+        key = TransferChecksum(key, &f->firstedge, sizeof(f->firstedge));
+        key = TransferChecksum(key, &f->numedges, sizeof(f->numedges));
+        key = TransferChecksum(key, &f->texinfo, sizeof(f->texinfo));
+    }
+
+    for (i = 0; i < g_opaque_face_count; i++)
+    {
+        const opaqueList_t* opaque = &g_opaque_face_list[i];
+
+        key = TransferChecksum(key, &opaque->facenum, sizeof(opaque->facenum));
+        key = TransferChecksum(key, &opaque->plane, sizeof(opaque->plane));
+#ifdef HLRAD_HULLU
+        key = TransferChecksum(key, opaque->transparency_scale, sizeof(opaque->transparency_scale));
+        key = TransferChecksum(key, &opaque->transparency, sizeof(opaque->transparency));
+#endif
+    }
+
+    return key;
+}
+
+static unsigned PatchKey(const patch_t* const patch)
+{
+    unsigned        key = 0;
+
+    key = TransferChecksum(key, patch->origin, sizeof(patch->origin));
+    key = TransferChecksum(key, &patch->area, sizeof(patch->area));
+    key = TransferChecksum(key, &patch->faceNumber, sizeof(patch->faceNumber));
+    return key;
+}
+
 /*
  * =============
  * writetransfers
@@ -25,15 +125,36 @@ void            writetransfers(const char* const transferfile, const long total_
     {
         unsigned        amtwritten;
         patch_t*        patch;
+        transferheader_t header;
+        unsigned*       keys;
+        long            i;
 
         Log("Writing transfers file [%s]\n", transferfile);
 
-        amtwritten = fwrite(&total_patches, sizeof(total_patches), 1, file);
+        header.ident = TRANSFERFILE_IDENT;
+        header.version = TRANSFERFILE_VERSION;
+        header.numpatches = total_patches;
+        header.worldkey = TransferWorldKey();
+        header.datasize = TransferDataSize();
+
+        amtwritten = fwrite(&header, sizeof(header), 1, file);
         if (amtwritten != 1)
         {
             goto FailedWrite;
         }
 
+        keys = (unsigned*)Alloc(total_patches * sizeof(unsigned));
+        for (i = 0, patch = g_patches; i < total_patches; i++, patch++)
+        {
+            keys[i] = PatchKey(patch);
+        }
+        amtwritten = fwrite(keys, sizeof(unsigned), total_patches, file);
+        Free(keys);
+        if (amtwritten != total_patches)
+        {
+            goto FailedWrite;
+        }
+
         long patchcount = total_patches;
         for (patch = g_patches; patchcount-- > 0; patch++)
         {
@@ -109,15 +230,52 @@ bool            readtransfers(const char* const transferfile, const long numpatc
         unsigned        amtread;
         patch_t*        patch;
 
+        transferheader_t header;
+        unsigned*       keys;
+        long            i;
+        long            changed;
+
         Log("Reading transfers file [%s]\n", transferfile);
 
-        amtread = fread(&total_patches, sizeof(total_patches), 1, file);
+        amtread = fread(&header, sizeof(header), 1, file);
         if (amtread != 1)
         {
             goto FailedRead;
         }
-        if (total_patches != numpatches)
+        if (header.ident != TRANSFERFILE_IDENT || header.version != TRANSFERFILE_VERSION)
+        {
+            Warning("Transfers file [%s] is from an older version of hlrad\n", transferfile);
+            goto FailedRead;
+        }
+        if (header.numpatches != numpatches || header.datasize != TransferDataSize())
+        {
+            goto FailedRead;
+        }
+        if (header.worldkey != TransferWorldKey())
+        {
+            Log("Transfers file [%s] is out of date: world geometry or opaque entities changed\n", transferfile);
+            goto FailedRead;
+        }
+        total_patches = header.numpatches;
+
+        keys = (unsigned*)Alloc(total_patches * sizeof(unsigned));
+        amtread = fread(keys, sizeof(unsigned), total_patches, file);
+        if (amtread != total_patches)
+        {
+            Free(keys);
+            goto FailedRead;
+        }
+        for (i = 0, changed = 0, patch = g_patches; i < total_patches; i++, patch++)
+        {
+            if (keys[i] != PatchKey(patch))
+            {
+                changed++;
+            }
+        }
+        Free(keys);
+        if (changed)
         {
+            Log("Transfers file [%s] is out of date: %ld of %ld patches changed\n", transferfile, changed, total_patches);
             goto FailedRead;
         }
 
@@ -131,7 +289,7 @@ bool            readtransfers(const char* const transferfile, const long numpatc
             }
             if (patch->iIndex)
             {
-                patch->tIndex = (transfer_index_t*)AllocBlock(patch->iIndex * sizeof(transfer_index_t *));
+                patch->tIndex = (transfer_index_t*)AllocBlock(patch->iIndex * sizeof(transfer_index_t));
                 hlassume(patch->tIndex != NULL, assume_NoMemory);
                 amtread = fread(patch->tIndex, sizeof(transfer_index_t), patch->iIndex, file);
                 if (amtread != patch->iIndex)
@@ -150,18 +308,18 @@ bool            readtransfers(const char* const transferfile, const long numpatc
 #ifdef HLRAD_HULLU
 		if(g_rgb_transfers)
 		{
-                    patch->tRGBData = (rgb_transfer_data_t*)AllocBlock(patch->iData * sizeof(rgb_transfer_data_t *));
+                    patch->tRGBData = (rgb_transfer_data_t*)AllocBlock(patch->iData * sizeof(rgb_transfer_data_t));
                     hlassume(patch->tRGBData != NULL, assume_NoMemory);
                     amtread = fread(patch->tRGBData, sizeof(rgb_transfer_data_t), patch->iData, file);		    
 		}
 		else
 		{
-                    patch->tData = (transfer_data_t*)AllocBlock(patch->iData * sizeof(transfer_data_t *));
+                    patch->tData = (transfer_data_t*)AllocBlock(patch->iData * sizeof(transfer_data_t));
                     hlassume(patch->tData != NULL, assume_NoMemory);
                     amtread = fread(patch->tData, sizeof(transfer_data_t), patch->iData, file);		    
 		}
 #else
-                patch->tData = (transfer_data_t*)AllocBlock(patch->iData * sizeof(transfer_data_t *));
+                patch->tData = (transfer_data_t*)AllocBlock(patch->iData * sizeof(transfer_data_t));
                 hlassume(patch->tData != NULL, assume_NoMemory);
                 amtread = fread(patch->tData, sizeof(transfer_data_t), patch->iData, file);
 #endif
@@ -31,15 +31,43 @@ static transparency_t *s_transparency_list = NULL;
 static unsigned long s_transparency_count = 0;
 static unsigned long s_max_transparency_count=0;
 
+static int CDECL CompareTransparency(const void* a, const void* b)
+{
+	const transparency_t* t1 = (const transparency_t*)a;
+	const transparency_t* t2 = (const transparency_t*)b;
+
+	if(t1->bitpos != t2->bitpos)
+		return t1->bitpos < t2->bitpos ? -1 : 1;
+	return 0;
+}
+
+// the list is filled in any order while the vismatrix is built, then sorted once
+// so MakeScales can binary search it instead of scanning it for every patch pair
+static void SortTransparencyList()
+{
+	if(s_transparency_count > 1)
+		qsort(s_transparency_list, s_transparency_count, sizeof(transparency_t), CompareTransparency);
+}
+
 static void FindOpacity(const unsigned bitpos, vec3_t &out)
 {
-	for(unsigned long i = 0; i < s_transparency_count; i++)
+	unsigned long lo = 0;
+	unsigned long hi = s_transparency_count;
+
+	while(lo < hi)
+	{
+		const unsigned long mid = (lo + hi) / 2;
+
+		if(s_transparency_list[mid].bitpos < bitpos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if(lo < s_transparency_count && s_transparency_list[lo].bitpos == bitpos)
 	{
-		if( s_transparency_list[i].bitpos == bitpos )
-		{
-			VectorCopy(s_transparency_list[i].transparency, out);
-			return;
-		}
+		VectorCopy(s_transparency_list[lo].transparency, out);
+		return;
 	}
 	VectorFill(out, 1.0);
 }
@@ -94,10 +122,10 @@ static void     TestPatchToFace(const unsigned patchnum, const int facenum, cons
 
 #ifdef HLRAD_HULLU
                     // transparency face fix table
-                    // TODO: this method makes MakeScale extreamly slow.. find new one
 
                     if(g_customshadow_with_bouncelight && fabs(VectorAvg(transparency) - 1.0) < 0.001)
                     {
+                    	ThreadLock();
                     	while(s_transparency_count >= s_max_transparency_count)
                     	{
                     	    //new size
@@ -116,6 +144,7 @@ static void     TestPatchToFace(const unsigned patchnum, const int facenum, cons
                     	s_transparency_list[s_transparency_count].bitpos = bitset;
 
                     	s_transparency_count++;
+                    	ThreadUnlock();
                     }
 #endif /*HLRAD_HULLU*/
 
@@ -364,6 +393,8 @@ void            MakeScalesVismatrix()
         g_CheckVisBit = CheckVisBitVismatrix;
 
 #ifdef HLRAD_HULLU
+        SortTransparencyList();
+
         if((s_max_transparency_count*sizeof(transparency_t))>=(1024 * 1024))
         	Log("%-20s: %5.1f megs\n", "custom shadow array", (s_max_transparency_count*sizeof(transparency_t)) / (1024 * 1024.0));
         else if(s_transparency_count)
@@ -313,6 +313,46 @@ static int      AllPortalsDone()
 // NETVIS
 ///////////
 
+#ifndef ZHLT_NETVIS
+// =====================================================================================
+//  SortPortals
+//      nummightsee does not change once BasePortalVis is done, so the order GetNextPortal
+//      hands portals out in can be fixed up front instead of rescanning every portal
+//      under the lock for each one
+// =====================================================================================
+static portal_t** s_sortedportals = NULL;
+static volatile long s_nextportal = 0;
+
+static int      CDECL ComparePortals(const void* a, const void* b)
+{
+    const portal_t* pa = *(const portal_t* const*)a;
+    const portal_t* pb = *(const portal_t* const*)b;
+
+    if (pa->nummightsee != pb->nummightsee)
+    {
+        return pa->nummightsee < pb->nummightsee ? -1 : 1;
+    }
+    return pa < pb ? -1 : (pa > pb ? 1 : 0);               // ties go to the lowest index, same as the old scan
+}
+
+static void     SortPortals()
+{
+    const int       numportals = g_numportals * 2;
+    int             i;
+
+    free(s_sortedportals);
+    s_sortedportals = (portal_t**)malloc(numportals * sizeof(portal_t*));
+    hlassume(s_sortedportals != NULL, assume_NoMemory);
+
+    for (i = 0; i < numportals; i++)
+    {
+        s_sortedportals[i] = &g_portals[i];
+    }
+    qsort(s_sortedportals, numportals, sizeof(portal_t*), ComparePortals);
+    s_nextportal = 0;
+}
+#endif
+
 // =====================================================================================
 //  GetNextPortal
 //      Returns the next portal for a thread to work on
@@ -320,21 +360,14 @@ static int      AllPortalsDone()
 // =====================================================================================
 static portal_t* GetNextPortal()
 {
+#ifdef ZHLT_NETVIS
     int             j;
     portal_t*       p;
     portal_t*       tp;
     int             min;
 
-#ifdef ZHLT_NETVIS
     if (g_vismode == VIS_MODE_SERVER)
     {
-#else
-    {
-        if (GetThreadWork() == -1)
-        {
-            return NULL;
-        }
-#endif
         ThreadLock();
 
         min = 99999;
@@ -346,9 +379,7 @@ static portal_t* GetNextPortal()
             {
                 min = tp->nummightsee;
                 p = tp;
-#ifdef ZHLT_NETVIS
                 g_visportalindex = j;
-#endif
             }
         }
 
@@ -361,7 +392,6 @@ static portal_t* GetNextPortal()
 
         return p;
     }
-#ifdef ZHLT_NETVIS
     else                                                   // AS CLIENT
     {
         while (getWorkFromClientQueue() == WAITING_FOR_PORTAL_INDEX)
@@ -392,6 +422,20 @@ static portal_t* GetNextPortal()
         }
         return (tp);
     }
+#else
+    portal_t*       p;
+    long            next;
+
+    if (GetThreadWork() == -1)
+    {
+        return NULL;
+    }
+
+    // GetThreadWork hands out exactly one token per portal, so the cursor never runs past the end
+    next = ThreadAtomicAdd(&s_nextportal, 1);
+    p = s_sortedportals[next];
+    p->status = stat_working;
+    return p;
 #endif
 }
 
@@ -671,7 +715,10 @@ static void     CalcPortalVis()
 #ifdef ZHLT_NETVIS
     LeafThread(0);
 #else
+    SortPortals();
     NamedRunThreadsOn(g_numportals * 2, g_estimate, LeafThread);
+    free(s_sortedportals);
+    s_sortedportals = NULL;
 #endif
 }
 